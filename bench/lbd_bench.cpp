@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <lbd/fe/lexer.h>
+#include <lbd/fe/parser.h>
+#include <lbd/intp/interpreter.h>
+#include <lbd/intp/stats.h>
+
+namespace bench {
+    struct Options {
+        size_t runs = 10;
+        size_t warmup = 2;
+        std::string filter;
+        std::string root = LBD_SOURCE_DIR;
+        std::optional<std::string> json_path;
+        std::optional<std::string> compare_path;
+        double threshold = 10.0; /// Percent slowdown of the median tolerated by --compare
+        bool show_help = false;
+    };
+
+    struct Workload {
+        std::string name;
+        std::function<void()> run;
+        std::function<void()> setup = nullptr; /// Untimed, before every warm-up and measured run
+    };
+
+    struct Result {
+        std::string name;
+        std::vector<double> times_ms; /// Sorted
+        uint64_t allocations; /// Per run
+        uint64_t bytes_allocated; /// Per run
+        std::optional<intp::stats::Snapshot> ops; /// Per run, when stats are compiled in
+
+        [[nodiscard]] double percentile(const double p) const {
+            // Nearest rank
+            const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(times_ms.size())));
+            return times_ms[std::clamp<size_t>(rank, 1, times_ms.size()) - 1];
+        }
+    };
+
+    /// Swallows the output of workloads
+    struct NullBuffer : std::streambuf {
+        int overflow(const int c) override {
+            return c;
+        }
+    };
+
+    // Counted by src/alloc_count.cpp, built with LBD_COUNT_ALLOCATIONS so Release builds count them too
+    static std::pair<uint64_t, uint64_t> allocation_counts() {
+        return {intp::stats::counters.allocations.load(), intp::stats::counters.bytes_allocated.load()};
+    }
+
+    static options::Options interpreter_options() {
+        options::Options options_v;
+        options_v.logger = logs::Logger(true, false, true);
+        return options_v;
+    }
+
+    static void run_file(const std::string &filepath) {
+        const options::Options options_v = interpreter_options();
+        // Every run starts from a clean slate, `use`d files are spliced in again
+        fe::parser::loaded_files().clear();
+        fe::lexer::Lexer lexer_v(filepath, fe::lexer::FromFile{}, options_v);
+        fe::parser::Parser parser(lexer_v, options_v);
+        const auto result = intp::interp::interpret(parser.program, std::nullopt, options_v);
+        // Recursive bindings keep their Env alive through their own Thunks, break the cycle
+        result.global_env->table.clear();
+    }
+
+    /// Private scratch directory of this process, holding the module cache and generated sources
+    static const std::filesystem::path &scratch_dir() {
+        static const std::filesystem::path dir = [] {
+            const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+            auto path = std::filesystem::temp_directory_path() / ("lbd-bench-" + std::to_string(ticks));
+            std::filesystem::create_directories(path);
+            std::filesystem::permissions(path, std::filesystem::perms::owner_all,
+                                         std::filesystem::perm_options::replace);
+            return path;
+        }();
+        return dir;
+    }
+
+    static std::filesystem::path module_cache_dir() {
+        return scratch_dir() / "cache";
+    }
+
+    /// Entry point of a program that `use`s many files, generated once into the scratch directory
+    static const std::string &use_heavy_program() {
+        static constexpr size_t MODULES = 32;
+        static constexpr size_t DEFS_PER_MODULE = 64;
+        static const std::string main_path = [] {
+            std::ofstream main_ofs(scratch_dir() / "main.lbd");
+            for (size_t m = 0; m < MODULES; ++m) {
+                const auto module_path = scratch_dir() / ("module_" + std::to_string(m) + ".lbd");
+                std::ofstream ofs(module_path);
+                for (size_t d = 0; d < DEFS_PER_MODULE; ++d) {
+                    ofs << "m" << m << "_f" << d << ": Float -> Float -> Float = \\x: Float. \\y: Float.\n"
+                            << "    (if_zero (sub x " << d << ") (mul y (add x " << m << ")) (mul (sub y x) 2))\n";
+                }
+                main_ofs << "use \"" << module_path.string() << "\"\n";
+            }
+            main_ofs << "(print (m" << MODULES - 1 << "_f" << DEFS_PER_MODULE - 1 << " 1 2) \"\\n\")\n";
+            return (scratch_dir() / "main.lbd").string();
+        }();
+        return main_path;
+    }
+
+    static void clear_module_cache() {
+        std::filesystem::remove_all(module_cache_dir());
+    }
+
+    static void fill_module_cache() {
+        if (!std::filesystem::exists(module_cache_dir())) {
+            run_file(use_heavy_program());
+        }
+    }
+
+    static const std::string &large_source() {
+        static const std::string source = [] {
+            std::ifstream ifs("examples/std.lbd", std::ios::in | std::ios::binary);
+            const std::string unit((std::istreambuf_iterator(ifs)), std::istreambuf_iterator<char>());
+            std::string out;
+            while (out.size() < (2u << 20)) {
+                out += unit;
+                out += '\n';
+            }
+            return out;
+        }();
+        return source;
+    }
+
+    static void lex_large_source() {
+        fe::lexer::Lexer lexer_v(large_source(), "<bench-lex>", fe::lexer::FromSource{}, interpreter_options());
+        while (!std::holds_alternative<fe::token::Eof>(lexer_v.next_token().typ)) {
+        }
+    }
+
+    static std::vector<Workload> workloads() {
+        return {
+            {"fibonacci", [] { run_file("examples/math_demos.lbd"); }},
+            {"aoc_day_01", [] { run_file("examples/aoc-24/day-01/part_01.lbd"); }},
+            {"list_kernels", [] { run_file("bench/workloads/list_kernels.lbd"); }},
+            {"deep_recursion", [] { run_file("bench/workloads/deep_recursion.lbd"); }},
+            {"large_file_lex", [] { lex_large_source(); }},
+            // Same program against an emptied and against a filled module cache
+            {"use_cold_cache", [] { run_file(use_heavy_program()); }, clear_module_cache},
+            {"use_warm_cache", [] { run_file(use_heavy_program()); }, fill_module_cache},
+        };
+    }
+
+    static Result measure(const Workload &workload, const Options &opts) {
+        NullBuffer null_buffer;
+        std::streambuf *const cout_buffer = std::cout.rdbuf(&null_buffer);
+        for (size_t i = 0; i < opts.warmup; ++i) {
+            if (workload.setup) workload.setup();
+            workload.run();
+        }
+        Result result{workload.name, {}, 0, 0, std::nullopt};
+        result.times_ms.reserve(opts.runs);
+        // The first setup may run the workload itself, keep it out of the counters
+        if (workload.setup) workload.setup();
+        intp::stats::reset();
+        const auto [allocations_before, bytes_before] = allocation_counts();
+        for (size_t i = 0; i < opts.runs; ++i) {
+            if (workload.setup && i > 0) workload.setup();
+            const auto start = std::chrono::steady_clock::now();
+            workload.run();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            result.times_ms.push_back(elapsed.count());
+        }
+        const auto [allocations_after, bytes_after] = allocation_counts();
+        std::cout.rdbuf(cout_buffer);
+        std::sort(result.times_ms.begin(), result.times_ms.end());
+        result.allocations = (allocations_after - allocations_before) / opts.runs;
+        result.bytes_allocated = (bytes_after - bytes_before) / opts.runs;
+        if (intp::stats::compiled_in) {
+            auto ops = intp::stats::snapshot();
+            ops.thunks_created /= opts.runs;
+            ops.thunks_forced /= opts.runs;
+            ops.thunk_cache_hits /= opts.runs;
+            ops.env_frames /= opts.runs;
+            ops.closure_applications /= opts.runs;
+            ops.native_calls /= opts.runs;
+            result.ops = ops;
+        }
+        return result;
+    }
+
+    static void write_json(std::ostream &os, const std::vector<Result> &results, const Options &opts) {
+        // One workload per line, which is what --compare reads back
+        os << std::fixed << std::setprecision(4) << "{\n"
+                << "  \"runs\": " << opts.runs << ",\n"
+                << "  \"warmup\": " << opts.warmup << ",\n"
+                << "  \"workloads\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result &r = results[i];
+            os << "    {\"name\": \"" << r.name << "\""
+                    << ", \"median_ms\": " << r.percentile(50)
+                    << ", \"p90_ms\": " << r.percentile(90)
+                    << ", \"p99_ms\": " << r.percentile(99)
+                    << ", \"min_ms\": " << r.times_ms.front()
+                    << ", \"max_ms\": " << r.times_ms.back()
+                    << ", \"allocations\": " << r.allocations
+                    << ", \"bytes_allocated\": " << r.bytes_allocated;
+            if (r.ops) {
+                os << ", \"thunks_forced\": " << r.ops->thunks_forced
+                        << ", \"closure_applications\": " << r.ops->closure_applications
+                        << ", \"native_calls\": " << r.ops->native_calls;
+            }
+            os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        os << "  ]\n}" << std::endl;
+    }
+
+    static void print_table(std::ostream &os, const std::vector<Result> &results) {
+        os << std::left << std::setw(18) << "workload" << std::right << std::setw(12) << "median ms"
+                << std::setw(12) << "p90 ms" << std::setw(12) << "p99 ms" << std::setw(12) << "min ms"
+                << std::setw(14) << "allocs/run" << std::endl;
+        os << std::fixed << std::setprecision(3);
+        for (const Result &r: results) {
+            os << std::left << std::setw(18) << r.name << std::right << std::setw(12) << r.percentile(50)
+                    << std::setw(12) << r.percentile(90) << std::setw(12) << r.percentile(99)
+                    << std::setw(12) << r.times_ms.front() << std::setw(14) << r.allocations << std::endl;
+        }
+    }
+
+    /// Median per workload from a file written by --json
+    static std::map<std::string, double> read_baseline(const std::string &path) {
+        std::ifstream ifs(path);
+        if (!ifs) {
+            std::cerr << "error: could not read baseline " << path << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        std::map<std::string, double> medians;
+        std::string line;
+        while (std::getline(ifs, line)) {
+            static const std::string name_key = "\"name\": \"";
+            static const std::string median_key = "\"median_ms\": ";
+            const size_t name_pos = line.find(name_key);
+            const size_t median_pos = line.find(median_key);
+            if (name_pos == std::string::npos || median_pos == std::string::npos) {
+                continue;
+            }
+            const size_t name_begin = name_pos + name_key.size();
+            const std::string name = line.substr(name_begin, line.find('"', name_begin) - name_begin);
+            medians[name] = std::strtod(line.c_str() + median_pos + median_key.size(), nullptr);
+        }
+        return medians;
+    }
+
+    /// Returns false when a workload regressed beyond the threshold
+    static bool compare(std::ostream &os, const std::vector<Result> &results, const Options &opts) {
+        const auto baseline = read_baseline(*opts.compare_path);
+        bool ok = true;
+        os << std::endl << std::left << std::setw(18) << "workload" << std::right << std::setw(14) << "baseline ms"
+                << std::setw(14) << "current ms" << std::setw(10) << "change" << std::endl;
+        for (const Result &r: results) {
+            const auto it = baseline.find(r.name);
+            if (it == baseline.end()) {
+                os << std::left << std::setw(18) << r.name << std::right << std::setw(14) << "-" << std::endl;
+                continue;
+            }
+            const double current = r.percentile(50);
+            const double change = it->second > 0 ? (current - it->second) / it->second * 100.0 : 0.0;
+            const bool regressed = change > opts.threshold;
+            ok = ok && !regressed;
+            os << std::left << std::setw(18) << r.name << std::right << std::fixed << std::setprecision(3)
+                    << std::setw(14) << it->second << std::setw(14) << current << std::setw(9)
+                    << std::setprecision(1) << std::showpos << change << "%" << std::noshowpos
+                    << (regressed ? "  REGRESSED" : "") << std::endl;
+        }
+        return ok;
+    }
+
+    static void print_help(std::ostream &os, const std::string &program_name) {
+        os << "usage: " << program_name << " [options]\n\n"
+                << "options:\n"
+                << "  --runs <n>              Measured runs per workload (default 10)\n"
+                << "  --warmup <n>            Unmeasured runs before measuring (default 2)\n"
+                << "  --filter <substring>    Only run workloads whose name contains <substring>\n"
+                << "  --root <dir>            Repository root holding the corpus (default the source tree)\n"
+                << "  --json <filepath>       Write results as JSON, `-` for stdout\n"
+                << "  --compare <filepath>    Compare medians against a JSON baseline, fail on regression\n"
+                << "  --threshold <percent>   Slowdown tolerated by --compare (default 10)\n"
+                << "  -h, --help              Show this help message and exit"
+                << std::endl;
+    }
+
+    static Options parse_args(const int argc, char **argv) {
+        Options opts;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "-h" || arg == "--help") {
+                opts.show_help = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cerr << "unknown option or missing value: " << arg << "\n";
+                print_help(std::cerr, argv[0]);
+                std::exit(EXIT_FAILURE);
+            }
+            const std::string value = argv[++i];
+            if (arg == "--runs") {
+                opts.runs = std::max<size_t>(1, std::stoul(value));
+            } else if (arg == "--warmup") {
+                opts.warmup = std::stoul(value);
+            } else if (arg == "--filter") {
+                opts.filter = value;
+            } else if (arg == "--root") {
+                opts.root = value;
+            } else if (arg == "--json") {
+                opts.json_path = value;
+            } else if (arg == "--compare") {
+                opts.compare_path = value;
+            } else if (arg == "--threshold") {
+                opts.threshold = std::stod(value);
+            } else {
+                std::cerr << "unknown option: " << arg << "\n";
+                print_help(std::cerr, argv[0]);
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        return opts;
+    }
+}
+
+int main(const int argc, char **argv) {
+    const bench::Options opts = bench::parse_args(argc, argv);
+    if (opts.show_help) {
+        bench::print_help(std::cout, argv[0]);
+        return EXIT_SUCCESS;
+    }
+    // Corpus paths are relative to the repository root
+    std::filesystem::current_path(opts.root);
+    // Keep the module cache away from the user's, so every workload sees a cache only this run has filled
+    ::setenv("LBD_CACHE_DIR", bench::module_cache_dir().c_str(), 1);
+
+    std::vector<bench::Result> results;
+    for (const auto &workload: bench::workloads()) {
+        if (workload.name.find(opts.filter) != std::string::npos) {
+            results.push_back(bench::measure(workload, opts));
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(bench::scratch_dir(), ec);
+
+    const bool json_to_stdout = opts.json_path && *opts.json_path == "-";
+    bench::print_table(json_to_stdout ? std::cerr : std::cout, results);
+    if (json_to_stdout) {
+        bench::write_json(std::cout, results, opts);
+    } else if (opts.json_path) {
+        std::ofstream ofs(*opts.json_path);
+        if (!ofs) {
+            std::cerr << "error: could not write results to " << *opts.json_path << std::endl;
+            return EXIT_FAILURE;
+        }
+        bench::write_json(ofs, results, opts);
+    }
+    if (opts.compare_path && !bench::compare(json_to_stdout ? std::cerr : std::cout, results, opts)) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -7,9 +7,19 @@
 namespace cmd {
     struct Options {
         std::optional<std::string> filepath;
+        std::optional<std::string> serve_socket;
+        std::optional<std::string> snapshot_path;
+        std::optional<std::string> image_path;
+        std::optional<std::string> profile_path;
+        std::optional<std::string> stats_json_path;
+        std::optional<std::string> trace_path;
+        std::optional<std::string> heap_profile_path;
         bool show_help = false;
         bool repl = false;
         bool debug = false;
+        bool no_cache = false;
+        bool stats = false;
+        bool fuse = false;
     };
 
     void print_help(std::ostream &os, const std::string &program_name);
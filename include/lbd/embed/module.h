@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include <lbd/fe/ast.h>
+#include <lbd/intp/interpreter.h>
+#include <lbd/options.h>
+
+namespace embed {
+    /// Errors are reported through ControlledExit instead of terminating the host process
+    options::Options default_options();
+
+    /// Conversions from C++ values into runtime Values
+    intp::interp::Value to_value(double value);
+
+    intp::interp::Value to_value(std::string_view value);
+
+    intp::interp::Value to_value(std::string &&value);
+
+    intp::interp::Value to_value(std::span<const double> values);
+
+    intp::interp::Value to_value(intp::interp::Value value);
+
+    /// Callable handle to an already forced lbd function, resolved once and reused across calls
+    struct Function {
+        intp::interp::Value callee;
+        std::shared_ptr<intp::interp::Env> env;
+
+        [[nodiscard]] intp::interp::Value apply(std::vector<intp::interp::Value> args) const;
+
+        template<typename... Args>
+        intp::interp::Value operator()(Args &&... args) const {
+            std::vector<intp::interp::Value> values;
+            values.reserve(sizeof...(Args));
+            (values.push_back(to_value(std::forward<Args>(args))), ...);
+            return apply(std::move(values));
+        }
+    };
+
+    /// A global Environment together with the Programs loaded into it.
+    /// Programs are kept alive for as long as the Module, as Thunks and Closures point into their AST.
+    struct Module {
+        explicit Module(options::Options options_ = default_options());
+
+        /// Add a Native Function into the global Environment (overrides bindings with the same name)
+        void register_native(intp::interp::NativeFunction native_fn);
+
+        /// Lex, parse and interpret a source file into the global Environment
+        intp::interp::Value load_file(const std::string &filepath);
+
+        /// Lex, parse and interpret source text into the global Environment
+        intp::interp::Value load_source(std::string source);
+
+        /// Lookup a global binding, nullptr when absent
+        [[nodiscard]] std::shared_ptr<intp::interp::Thunk> lookup(const std::string &name) const;
+
+        /// Force a global binding and return its Value
+        [[nodiscard]] const intp::interp::Value &get(const std::string &name) const;
+
+        /// Resolve a global binding into a reusable callable handle
+        [[nodiscard]] Function function(const std::string &name) const;
+
+        template<typename... Args>
+        intp::interp::Value call(const std::string &name, Args &&... args) const {
+            return function(name)(std::forward<Args>(args)...);
+        }
+
+        [[nodiscard]] const std::shared_ptr<intp::interp::Env> &global_env() const;
+
+    private:
+        options::Options options_v;
+        std::shared_ptr<intp::interp::Env> env;
+        std::vector<std::unique_ptr<fe::ast::Program> > programs;
+        std::unordered_set<std::string> loaded_files; /// Files pulled in through `use` by this Module
+
+        intp::interp::Value load(std::unique_ptr<fe::ast::Program> program);
+    };
+}
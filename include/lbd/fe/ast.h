@@ -2,6 +2,9 @@
 
 #include <lbd/fe/loc.h>
 #include <lbd/intp/types.h>
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
 #include <variant>
 #include <vector>
@@ -28,30 +31,30 @@ namespace fe::ast {
         friend std::ostream &operator<<(std::ostream &os, const FloatAstNode &node);
     };
 
-    struct Expression;
+    /// Index of an Expression within its Arena
+    using ExprId = uint32_t;
+
+    struct Arena;
 
     struct LambdaExpression {
         IdenAstNode arg;
         intp::types::Type arg_type;
-        std::unique_ptr<Expression> expr;
+        ExprId expr;
         loc::Loc loc;
         /// Maybe, this is redundant
         /// TODO: Remove after checking
         intp::types::CompoundType lmd_expr_type; // Lambda Expression Type
 
-        void print(std::ostream &os, size_t indent) const;
-
-        friend std::ostream &operator<<(std::ostream &os, const LambdaExpression &l_expr);
+        void print(std::ostream &os, const Arena &arena, size_t indent) const;
     };
 
     struct FunctionApplication {
         IdenAstNode fn_name;
-        std::vector<std::unique_ptr<Expression> > args;
+        uint32_t args_begin = 0; /// First argument in Arena::args
+        uint32_t args_count = 0;
         loc::Loc loc;
 
-        void print(std::ostream &os, size_t indent) const;
-
-        friend std::ostream &operator<<(std::ostream &os, const FunctionApplication &fn_apl);
+        void print(std::ostream &os, const Arena &arena, size_t indent) const;
     };
 
     struct Expression {
@@ -75,43 +78,69 @@ namespace fe::ast {
 
         explicit Expression(FunctionApplication value);
 
-        void print(std::ostream &os, size_t indent) const;
-
-        friend std::ostream &operator<<(std::ostream &os, const Expression &expr);
+        void print(std::ostream &os, const Arena &arena, size_t indent) const;
 
         [[nodiscard]] loc::Loc get_loc() const;
+    };
+
+    /// Contiguous storage for the Expressions of a source or Program, children are referenced by 32-bit index.
+    /// Children are added before their parent, Expressions are never removed or reordered.
+    struct Arena {
+        std::vector<Expression> exprs;
+        std::vector<ExprId> args; /// Argument lists of Function Applications, each one contiguous
 
-        Expression(const Expression &) = delete;
+        ExprId add(Expression expr);
 
-        Expression &operator=(const Expression &) = delete;
+        [[nodiscard]] const Expression &operator[](const ExprId id) const {
+            return exprs[id];
+        }
 
-        Expression(Expression &&) noexcept = default;
+        [[nodiscard]] std::span<const ExprId> args_of(const FunctionApplication &fn_apl) const {
+            return {args.data() + fn_apl.args_begin, fn_apl.args_count};
+        }
 
-        Expression &operator=(Expression &&) noexcept = default;
+        /// Move other's Expressions to the end of this Arena and return the offset added to their ids
+        ExprId append(Arena &&other);
     };
 
     struct DefAstNode {
         IdenAstNode def_name;
         intp::types::Type typ;
-        Expression expr;
+        ExprId expr;
         loc::Loc loc;
 
-        void print(std::ostream &os, size_t indent) const;
-
-        friend std::ostream &operator<<(std::ostream &os, const DefAstNode &node);
+        void print(std::ostream &os, const Arena &arena, size_t indent) const;
     };
 
     struct AstNode {
-        using NodeVariant = std::variant<Expression, DefAstNode>;
+        using NodeVariant = std::variant<ExprId, DefAstNode>;
 
         NodeVariant value;
 
-        void print(std::ostream &os, size_t indent) const;
+        void print(std::ostream &os, const Arena &arena, size_t indent) const;
+
+        /// Shift the Expression ids of this node after its Arena was appended to another
+        void rebase(ExprId offset);
+    };
+
+    /// `use "<filepath>"` directive, kept unresolved until the file's items are spliced into a Program
+    struct UseDirective {
+        std::string filepath;
+        loc::Loc loc;
+    };
+
+    /// Top-level item of a single source file
+    using UnitItem = std::variant<AstNode, UseDirective>;
 
-        friend std::ostream &operator<<(std::ostream &os, const AstNode &node);
+    /// Parsed source file, its items refer into its own Arena
+    struct Unit {
+        Arena arena;
+        std::vector<UnitItem> items;
     };
 
     struct Program {
+        /// Shared, so Thunks bound in the REPL can keep the Expressions of a discarded Program alive
+        std::shared_ptr<Arena> arena = std::make_shared<Arena>();
         std::vector<AstNode> nodes;
 
         friend std::ostream &operator<<(std::ostream &os, const Program &p);
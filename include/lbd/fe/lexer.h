@@ -3,7 +3,11 @@
 #include <lbd/fe/loc.h>
 #include <lbd/fe/token.h>
 #include <lbd/options.h>
+#include <lbd/utils/mapped_file.h>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace fe::lexer {
@@ -13,22 +17,38 @@ namespace fe::lexer {
     struct FromRepl {
     };
 
+    struct FromSource {
+    };
+
+    /// Yields tokens on demand. Iden and String tokens are slices of source, so the Lexer must outlive them.
     struct Lexer {
-        std::string source;
+        std::string_view source; /// Memory-mapped file, owned REPL input or borrowed buffer
         size_t pos = 0;
-        size_t row = 1;
-        size_t col = 1;
-        std::string filepath;
+        uint32_t file_id = 0;
 
+        /// Memory-maps the file instead of reading it
         Lexer(const std::string &filepath, FromFile, options::Options options_ = {});
 
         Lexer(std::string str, FromRepl, options::Options options_ = {});
 
+        /// Borrows source, which must outlive the Lexer, locations are attributed to filepath
+        Lexer(std::string_view source, std::string filepath, FromSource, options::Options options_ = {});
+
+        Lexer(const Lexer &) = delete;
+
+        Lexer &operator=(const Lexer &) = delete;
+
         token::Token next_token();
 
         std::vector<token::Token> lex_all();
 
     private:
+        std::unique_ptr<MappedFile> mapped;
+        std::string owned;
+        loc::SourceFile *file = nullptr;
+
+        void init(std::string filepath);
+
         [[nodiscard]] char peek() const;
 
         char get();
@@ -37,4 +57,20 @@ namespace fe::lexer {
 
         [[nodiscard]] loc::Loc get_cur_loc() const;
     };
+
+    /// Token source for the parser, pulls from a Lexer with a single token of lookahead
+    struct TokenStream {
+        explicit TokenStream(Lexer &lexer_v);
+
+        [[nodiscard]] const token::Token &peek() const;
+
+        void advance();
+
+        uint64_t lex_ns = 0; /// Time spent in the Lexer, only accumulated while tracing
+
+    private:
+        Lexer &lexer_v;
+        token::Token cur;
+        bool debug; /// Log tokens as they are consumed
+    };
 }
@@ -1,15 +1,66 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace fe::loc {
-    struct Loc {
-        size_t row;
-        size_t col;
+    /// Source file registered with the source manager
+    struct SourceFile {
         std::string filepath;
+        std::vector<uint32_t> line_starts{0}; /// Byte offset of each line, appended while lexing
+
+        [[nodiscard]] size_t row(uint32_t offset) const;
+
+        [[nodiscard]] size_t col(uint32_t offset) const;
+    };
+
+    /// Register a source file and return its id, safe to call from concurrent lexers.
+    /// Reuses the entry of a released file when there is one.
+    uint32_t register_file(std::string filepath);
+
+    /// Entries are never moved, references stay valid. A released entry is reset when it is reused.
+    SourceFile &get_file(uint32_t file_id);
+
+    /// Releases every file registered, from any thread, while it is the innermost live EphemeralFiles,
+    /// unless keep() was called. Nested scopes defer the release to the outermost one. For sources whose AST
+    /// and Locs do not outlive it, such as serve requests and REPL inputs, which would otherwise grow the file
+    /// table by one entry each.
+    struct EphemeralFiles {
+        EphemeralFiles();
+
+        ~EphemeralFiles();
+
+        EphemeralFiles(const EphemeralFiles &) = delete;
+
+        EphemeralFiles &operator=(const EphemeralFiles &) = delete;
+
+        /// The registered files are never released, some Loc into them outlives every scope
+        void keep();
+
+    private:
+        std::vector<uint32_t> file_ids;
+        EphemeralFiles *outer;
+        bool kept = false;
+
+        friend uint32_t register_file(std::string filepath);
+    };
+
+    /// Compact source location, row and column are only computed when printing diagnostics
+    struct Loc {
+        uint32_t file_id = 0; /// 0 is reserved for unknown locations
+        uint32_t offset = 0;
+
+        Loc() = default;
+
+        Loc(uint32_t file_id, uint32_t offset);
+
+        [[nodiscard]] const std::string &filepath() const;
+
+        [[nodiscard]] size_t row() const;
 
-        Loc(size_t row, size_t col, std::string filepath);
+        [[nodiscard]] size_t col() const;
 
         friend std::ostream &operator<<(std::ostream &os, const Loc &loc);
     };
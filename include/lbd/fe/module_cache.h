@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <lbd/fe/ast.h>
+#include <lbd/options.h>
+
+/// On-disk cache of parsed `use` files (.lbdc).
+/// Entries are keyed by absolute filepath, content hash, fe::serialize::FORMAT_VERSION and build id, and hold the file's
+/// parsed Unit with nested `use` directives unresolved, so duplicate and cycle detection still applies.
+/// The cache lives in $LBD_CACHE_DIR, or in $XDG_CACHE_HOME/lbd or ~/.cache/lbd when unset, created private to
+/// the current user. Directories and entries owned by anyone else are ignored.
+namespace fe::module_cache {
+    /// FNV-1a 64-bit hash
+    uint64_t hash(std::string_view data);
+
+    /// Empty when no cache location can be determined, which disables the cache
+    std::filesystem::path cache_dir();
+
+    std::optional<ast::Unit> load(const std::string &abs_path, uint64_t content_hash, const options::Options &options_);
+
+    /// Best-effort, failures to write the cache are ignored
+    void store(const std::string &abs_path, uint64_t content_hash, const ast::Unit &unit,
+               const options::Options &options_);
+}
@@ -2,38 +2,47 @@
 
 #include <lbd/options.h>
 #include <lbd/fe/ast.h>
+#include <lbd/fe/lexer.h>
 #include <lbd/fe/token.h>
 #include <lbd/intp/types.h>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace fe::parser {
+    /// Absolute filepaths already pulled in through `use`, shared by every Parser.
+    /// Guarded internally while parsing; callers must not modify it concurrently with a Parser.
+    std::unordered_set<std::string> &loaded_files();
+
     struct Parser {
         ast::Program program;
 
-        explicit Parser(const std::vector<token::Token> &tokens, options::Options options_ = {});
+        /// Pulls tokens from lexer_v as it parses, no token vector is materialized
+        explicit Parser(lexer::Lexer &lexer_v, options::Options options_ = {});
+
+        /// Parse the top-level items of a single source into its own Arena, leaving `use` directives unresolved
+        static ast::Unit build_unit(lexer::TokenStream &tokens);
 
     private:
         // TODO: Add checks for T to be a variant of fe::token::TokenType
         template<typename T>
-        static void assert_token(const std::vector<token::Token> &tokens, size_t &i);
+        static void assert_token(lexer::TokenStream &tokens);
 
         template<typename T>
-        static void assert_n_eat(const std::vector<token::Token> &tokens, size_t &i);
-
-        static ast::IdenAstNode eat_iden(const std::vector<token::Token> &tokens, size_t &i);
+        static void assert_n_eat(lexer::TokenStream &tokens);
 
-        static intp::types::PrimitiveType eat_primitive_type_name(const std::vector<token::Token> &tokens, size_t &i);
+        static ast::IdenAstNode eat_iden(lexer::TokenStream &tokens);
 
-        static intp::types::Type parse_type(const std::vector<token::Token> &tokens, size_t &i);
+        static intp::types::PrimitiveType eat_primitive_type_name(lexer::TokenStream &tokens);
 
-        static ast::Expression parse_expression(const std::vector<token::Token> &tokens, size_t &i);
+        static intp::types::Type parse_type(lexer::TokenStream &tokens);
 
-        static ast::LambdaExpression parse_lambda_expression(const std::vector<token::Token> &tokens, size_t &i);
+        static ast::ExprId parse_expression(lexer::TokenStream &tokens, ast::Arena &arena);
 
-        static ast::FunctionApplication parse_function_application(const std::vector<token::Token> &tokens, size_t &i);
+        static ast::LambdaExpression parse_lambda_expression(lexer::TokenStream &tokens, ast::Arena &arena);
 
-        static ast::DefAstNode parse_def_ast_node(const std::vector<token::Token> &tokens, size_t &i);
+        static ast::FunctionApplication parse_function_application(lexer::TokenStream &tokens, ast::Arena &arena);
 
-        static std::vector<ast::AstNode> build_ast(const std::vector<token::Token> &tokens, size_t &i);
+        static ast::DefAstNode parse_def_ast_node(lexer::TokenStream &tokens, ast::Arena &arena);
     };
 }
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <lbd/fe/ast.h>
+#include <lbd/options.h>
+
+namespace fe::serialize {
+    /// Bumped whenever the binary layout of serialized AST or images changes
+    constexpr uint32_t FORMAT_VERSION = 4;
+
+    /// Identifies the interpreter build, checked next to FORMAT_VERSION.
+    /// Lexer and parser changes alter the serialized ASTs without touching the binary layout.
+    std::string_view build_id();
+
+    /// Native-endian binary encoder into an in-memory buffer
+    struct Writer {
+        std::string buffer;
+        std::unordered_map<uint32_t, uint32_t> file_ids; /// Source manager file id to stream-local index
+
+        void u8(uint8_t value);
+
+        void u32(uint32_t value);
+
+        void u64(uint64_t value);
+
+        void f64(double value);
+
+        void str(std::string_view value);
+    };
+
+    /// Decoder over a borrowed byte range, reports truncated or corrupt input through the logger
+    struct Reader {
+        const char *data;
+        size_t size;
+        size_t pos = 0;
+        options::Options options_v;
+        std::vector<uint32_t> file_ids; /// Stream-local index to source manager file id
+
+        Reader(const char *data, size_t size, options::Options options_ = {});
+
+        uint8_t u8();
+
+        uint32_t u32();
+
+        uint64_t u64();
+
+        double f64();
+
+        std::string str();
+
+        [[nodiscard]] bool is_eof() const;
+
+    private:
+        void require(size_t n);
+    };
+
+    void write_loc(Writer &w, const loc::Loc &loc);
+
+    loc::Loc read_loc(Reader &r);
+
+    void write_type(Writer &w, const intp::types::Type &typ);
+
+    intp::types::Type read_type(Reader &r);
+
+    /// Expressions are written in Arena order, argument lists as one contiguous block
+    void write_arena(Writer &w, const ast::Arena &arena);
+
+    ast::Arena read_arena(Reader &r);
+
+    void write_ast_node(Writer &w, const ast::AstNode &node);
+
+    /// Expression ids are checked against arena, the Arena the node was written with
+    ast::AstNode read_ast_node(Reader &r, const ast::Arena &arena);
+}
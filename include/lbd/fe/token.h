@@ -1,16 +1,20 @@
 #pragma once
 
+#include <lbd/error.h>
 #include <lbd/fe/loc.h>
 #include <string>
+#include <string_view>
 #include <variant>
 
 namespace fe::token {
+    /// Borrows a slice of the Lexer's source, valid for as long as the Lexer
     struct Iden {
-        std::string value;
+        std::string_view value;
     };
 
+    /// Borrows a slice of the Lexer's source, still escaped
     struct String {
-        std::string value;
+        std::string_view value;
     };
 
     struct Colon {
@@ -68,5 +72,34 @@ namespace fe::token {
     };
 
     template<typename T>
-    std::string to_string();
+    std::string to_string() {
+        if constexpr (std::is_same_v<T, std::monostate>) {
+            return {"NULL"};
+        } else if constexpr (std::is_same_v<T, Iden>) {
+            return {"ID"};
+        } else if constexpr (std::is_same_v<T, String>) {
+            return {"STRING"};
+        } else if constexpr (std::is_same_v<T, Colon>) {
+            return {"COLON"};
+        } else if constexpr (std::is_same_v<T, Equal>) {
+            return {"EQUAL"};
+        } else if constexpr (std::is_same_v<T, Float>) {
+            return {"FLOAT"};
+        } else if constexpr (std::is_same_v<T, Arrow>) {
+            return {"ARROW"};
+        } else if constexpr (std::is_same_v<T, BackwardSlash>) {
+            return {"BACKWARD_SLASH"};
+        } else if constexpr (std::is_same_v<T, Dot>) {
+            return {"DOT"};
+        } else if constexpr (std::is_same_v<T, OpenParen>) {
+            return {"OPEN_PAREN"};
+        } else if constexpr (std::is_same_v<T, CloseParen>) {
+            return {"CLOSE_PAREN"};
+        } else if constexpr (std::is_same_v<T, Eof>) {
+            return {"EOF"};
+        } else {
+            STATIC_ASSERT_UNREACHABLE_T(T, "unhandled token");
+            return {"UNKNOWN_TOKEN"}; // Unreachable
+        }
+    }
 }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+/// Timeline of lexing, parsing, `use` loads and evaluation in Chrome/Perfetto trace-event JSON.
+/// Every thread appends to its own buffer without locking, buffers are only merged by write().
+namespace fe::trace {
+    /// Checked by every Span, set before any worker thread starts
+    inline bool enabled = false;
+
+    /// Native calls shorter than this are not recorded
+    inline uint64_t builtin_threshold_us = 100;
+
+    /// Microseconds since start()
+    uint64_t now_us();
+
+    void start();
+
+    void stop();
+
+    /// Complete ("X") event, args is a JSON object body without braces or empty
+    void record(std::string name, const char *category, uint64_t start_us, uint64_t dur_us, std::string args = {});
+
+    /// Write every recorded event as a trace-event JSON object
+    void write(std::ostream &os);
+
+    /// RAII complete event, name and args may be filled in while it is open
+    struct Span {
+        const char *category;
+        std::string name;
+        std::string args;
+        uint64_t start_us = 0;
+        bool active;
+
+        explicit Span(const char *category) : category(category), active(enabled) {
+            if (active) start_us = now_us();
+        }
+
+        ~Span() {
+            if (active) record(std::move(name), category, start_us, now_us() - start_us, std::move(args));
+        }
+
+        explicit operator bool() const {
+            return active;
+        }
+
+        Span(const Span &) = delete;
+
+        Span &operator=(const Span &) = delete;
+    };
+
+    /// JSON string literal of value, quotes included
+    std::string quote(const std::string &value);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <lbd/intp/builtins.h>
+
+namespace intp::interp::builtins {
+    NativeFunction make_dict();
+
+    NativeFunction make_dict_get();
+
+    NativeFunction make_dict_put();
+
+    NativeFunction make_dict_keys();
+
+    NativeFunction make_frequencies();
+
+    NativeFunction make_group_by();
+}
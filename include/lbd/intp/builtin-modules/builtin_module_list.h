@@ -19,7 +19,40 @@ namespace intp::interp::builtins {
 
     NativeFunction make_sort();
 
+    /// Sort by a key computed once per element, stable
+    NativeFunction make_sort_by();
+
+    /// Sort by a comparator returning a negative, zero or positive Float, stable
+    NativeFunction make_sort_with();
+
     NativeFunction make_zip();
 
     NativeFunction make_foldr();
+
+    /// Persistent updates, the argument List is left unchanged
+    NativeFunction make_push();
+
+    NativeFunction make_set();
+
+    NativeFunction make_concat();
+
+    NativeFunction make_slice();
+
+    /// Searches and merges on Lists sorted ascending, as by sort.
+    /// bsearch returns the index of an equal element or -1.
+    NativeFunction make_bsearch();
+
+    NativeFunction make_lower_bound();
+
+    NativeFunction make_upper_bound();
+
+    NativeFunction make_unique();
+
+    /// Multiset semantics, an element repeated m times in one List and n in the other
+    /// appears min(m, n), max(m, n) and max(m - n, 0) times respectively
+    NativeFunction make_intersect();
+
+    NativeFunction make_union();
+
+    NativeFunction make_difference();
 }
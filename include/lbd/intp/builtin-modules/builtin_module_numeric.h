@@ -0,0 +1,25 @@
+#pragma once
+
+#include <lbd/intp/builtins.h>
+
+namespace intp::interp::builtins {
+    NativeFunction make_sum();
+
+    NativeFunction make_product();
+
+    NativeFunction make_min();
+
+    NativeFunction make_max();
+
+    NativeFunction make_mean();
+
+    NativeFunction make_dot();
+
+    NativeFunction make_vadd();
+
+    NativeFunction make_vsub();
+
+    NativeFunction make_vmul();
+
+    NativeFunction make_vscale();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <lbd/intp/builtins.h>
+
+namespace intp::interp::builtins {
+    /// Value of a List argument with adjacent stages fused: an unevaluated `(zip xss)` of the builtin, or
+    /// `(map f xs)` when Options::fuse_maps is on, becomes a Stream over the fused source of its own argument,
+    /// anything else is forced. zip calls no functions, so fusing it is never observable. A fused map calls f
+    /// once per element as the consumer reads it, instead of for every element before the consumer starts.
+    /// Argument Thunks belong to a single Function Application, so the List skipped could never be read again.
+    Value fused_source(const std::shared_ptr<Thunk> &arg);
+
+    /// Calls fn with every element of a List or Stream in order until fn returns false
+    void for_each_element(const std::string &name, const Value &source, const std::function<bool(const Value &)> &fn);
+
+    NativeFunction make_range();
+
+    NativeFunction make_iterate();
+
+    NativeFunction make_take();
+
+    NativeFunction make_filter();
+
+    NativeFunction make_drop_while();
+
+    NativeFunction make_map_lazy();
+
+    NativeFunction make_to_list();
+
+    /// Strict left folds, each step reuses the previous step's argument Thunks and Environment frames
+    NativeFunction make_foldl();
+
+    NativeFunction make_foldl_strict();
+
+    /// Left fold that returns the first accumulator for which stop holds, without reading further elements
+    NativeFunction make_fold_until();
+}
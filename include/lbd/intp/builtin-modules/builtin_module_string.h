@@ -0,0 +1,15 @@
+#pragma once
+
+#include <lbd/intp/builtins.h>
+
+namespace intp::interp::builtins {
+    /// Every String builtin also accepts a Rope, concat in the List module builds them
+    NativeFunction make_join();
+
+    NativeFunction make_str_len();
+
+    NativeFunction make_substr();
+
+    /// Shortest text that parses back to the same Float, unlike print's fixed six decimals
+    NativeFunction make_to_string();
+}
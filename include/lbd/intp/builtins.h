@@ -7,4 +7,10 @@ namespace intp::interp::builtins {
     extern options::Options options_v;
 
     std::vector<NativeFunction> get_builtins(options::Options options_ = {});
+
+    /// Characters of a String or Rope, nullptr for any other Value. A Rope is flattened on first use.
+    const std::string *text_of(const Value &value);
+
+    /// value as an index or count, raises a runtime error unless it is a non-negative whole Float
+    size_t index_arg(const std::string &name, const char *signature, const Value &value);
 }
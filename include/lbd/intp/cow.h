@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+
+namespace intp::interp {
+    struct Env;
+    struct List;
+    struct Thunk;
+}
+
+/// Copy-on-write sharing of a long-lived heap, such as the serve prelude, between short-lived evaluations.
+/// Freezing marks every Env, Thunk and List reachable from a root. list_append and list_remove save a frozen
+/// List's contents before changing it for the first time, and thaw puts the saved contents back, in O(1) per List
+/// as the contents are persistent vectors. A frozen Thunk computed later freezes and keeps its Value,
+/// unless a frozen List had been changed by then, in which case the Value may depend on the change and thaw drops it.
+namespace intp::cow {
+    void freeze(const std::shared_ptr<interp::Env> &root);
+
+    /// Called by the builtins before they change a frozen List in place
+    void before_write(const std::shared_ptr<interp::List> &list);
+
+    /// Called once a frozen Thunk has computed its Value
+    void on_computed(const interp::Thunk &thunk);
+
+    /// Restore every frozen List changed since the last thaw and forget Values computed from the changes
+    void thaw();
+}
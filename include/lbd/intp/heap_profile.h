@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <lbd/fe/loc.h>
+
+namespace intp::interp {
+    struct Env;
+}
+
+/// Heap profile of live Thunks, Envs and Lists by the source location that created them.
+/// Objects are attributed to their definition, or else to the innermost Function Application being evaluated.
+/// Closures are values without identity, so their creations are counted apart from the live objects,
+/// while the Envs they capture are tracked like any other.
+namespace intp::heap {
+    enum class Kind : uint8_t { Thunk, Env, List };
+
+    /// Checked on every creation and destruction, objects created while off are never tracked
+    inline bool enabled = false;
+
+    void start();
+
+    void stop();
+
+    void track(const void *object, Kind kind, const std::optional<fe::loc::Loc> &loc);
+
+    void untrack(const void *object);
+
+    void count_closure(const fe::loc::Loc &loc);
+
+    /// Innermost Function Application being evaluated on this thread
+    const std::optional<fe::loc::Loc> &current_site();
+
+    void set_current_site(const std::optional<fe::loc::Loc> &loc);
+
+    inline void on_create(const void *object, const Kind kind, const std::optional<fe::loc::Loc> &loc = std::nullopt) {
+        if (enabled) track(object, kind, loc ? loc : current_site());
+    }
+
+    inline void on_destroy(const void *object) {
+        if (enabled) untrack(object);
+    }
+
+    /// RAII attribution of objects created while evaluating a Function Application
+    struct SiteScope {
+        std::optional<fe::loc::Loc> prev;
+        bool active;
+
+        explicit SiteScope(const fe::loc::Loc &loc) : active(enabled) {
+            if (active) {
+                prev = current_site();
+                set_current_site(loc);
+            }
+        }
+
+        ~SiteScope() {
+            if (active) set_current_site(prev);
+        }
+
+        SiteScope(const SiteScope &) = delete;
+
+        SiteScope &operator=(const SiteScope &) = delete;
+    };
+
+    /// Live objects per site by bytes, closures created per lambda and the global bindings reaching the most memory,
+    /// at most limit rows each
+    void report(std::ostream &os, const std::shared_ptr<interp::Env> &global_env, size_t limit = 20);
+
+    /// Live objects per site and kind, then closures created per site, as tab separated lines sorted by site,
+    /// stable for diffing runs
+    void write(std::ostream &os);
+}
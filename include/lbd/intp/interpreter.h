@@ -1,24 +1,34 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <lbd/fe/ast.h>
 #include <lbd/fe/parser.h>
+#include <lbd/intp/stats.h>
 #include <lbd/options.h>
+#include <lbd/utils/hamt.h>
+#include <lbd/utils/pvector.h>
 
 namespace intp::interp {
     struct NativeFunction;
     struct Thunk;
     struct Env;
     struct List;
+    struct Stream;
+    struct Dict;
+    struct Rope;
     struct Value;
 
     /// Runtime representation of Lambda Expression
     struct Closure {
         std::string param;
-        const fe::ast::Expression *body; /// Non-owning, read-only AST pointer
+        const fe::ast::Arena *arena; /// Non-owning, read-only AST storage
+        fe::ast::ExprId body;
         std::shared_ptr<Env> env; /// Environment at the time of Lambda Expression creation
 
         [[nodiscard]] std::string to_string() const;
@@ -26,20 +36,128 @@ namespace intp::interp {
         friend std::ostream &operator<<(std::ostream &os, const Closure &closure);
     };
 
+    /// Shared holder of a persistent vector. The list_* builtins replace the vector in place,
+    /// every other List builtin returns a new List sharing structure with its inputs.
+    /// Lists of only Floats keep them unboxed, the first insertion of anything else boxes every element.
     struct List {
-        std::vector<Value> elements;
+        PVector<Value> elements; /// Empty while numeric
+        PVector<double> floats; /// Empty unless numeric
+        bool numeric = true;
+        bool frozen = false; /// Shared through intp::cow, kept by the object when its contents are replaced
+
+        List();
+
+        explicit List(PVector<Value> elements);
+
+        explicit List(PVector<double> floats);
+
+        /// Unboxed when every element is a Float
+        explicit List(std::vector<Value> elements);
+
+        explicit List(std::vector<double> floats);
+
+        List(const List &other);
+
+        List(List &&other) noexcept;
+
+        List &operator=(const List &other);
+
+        List &operator=(List &&other) noexcept;
+
+        ~List();
+
+        [[nodiscard]] size_t size() const;
+
+        [[nodiscard]] bool empty() const;
+
+        /// Element at index, index must be in range
+        [[nodiscard]] Value at(size_t index) const;
+
+        /// Generic representation, boxes a numeric List's elements
+        [[nodiscard]] PVector<Value> boxed() const;
+
+        [[nodiscard]] List push_back(Value value) const;
+
+        [[nodiscard]] List set(size_t index, Value value) const;
+
+        [[nodiscard]] List erase(size_t index) const;
+
+        [[nodiscard]] List slice(size_t begin, size_t end) const;
+
+        [[nodiscard]] static List concat(const List &a, const List &b);
+
+        /// Calls fn with each element as a const Value &, in order
+        template<typename F>
+        void for_each(F &&fn) const;
 
         [[nodiscard]] std::string to_string() const;
 
         friend std::ostream &operator<<(std::ostream &os, const List &list);
     };
 
+    /// Immutable text built by concatenation. Joining two texts links them under a new node in O(1)
+    /// and merges short pieces into one leaf. The characters are copied into a single string only when
+    /// something needs them contiguous, after which the Rope is a leaf holding that string.
+    struct Rope {
+        /// Pieces that together fit in this many bytes share a leaf
+        static constexpr size_t LEAF_MAX = 64;
+
+        size_t length;
+        mutable std::string text; /// Leaf text, or the whole text once flattened
+        mutable std::shared_ptr<Rope> left; /// Null for a leaf
+        mutable std::shared_ptr<Rope> right;
+
+        explicit Rope(std::string text);
+
+        Rope(std::shared_ptr<Rope> left, std::shared_ptr<Rope> right);
+
+        Rope(const Rope &) = delete;
+
+        Rope &operator=(const Rope &) = delete;
+
+        /// Releases long chains without recursing once per node
+        ~Rope();
+
+        [[nodiscard]] static std::shared_ptr<Rope> concat(const std::shared_ptr<Rope> &a,
+                                                          const std::shared_ptr<Rope> &b);
+
+        /// Calls fn with each leaf as a std::string_view, in order
+        template<typename F>
+        void for_each_chunk(F &&fn) const;
+
+        /// The whole text, flattening the Rope into a leaf on first use
+        const std::string &flat() const;
+
+        [[nodiscard]] std::string to_string() const;
+
+        friend std::ostream &operator<<(std::ostream &os, const Rope &rope);
+    };
+
+    template<typename F>
+    void Rope::for_each_chunk(F &&fn) const {
+        // A Rope built in a loop is as deep as it has leaves, so the walk keeps its own stack
+        std::vector<const Rope *> pending{this};
+        while (!pending.empty()) {
+            const Rope *node = pending.back();
+            pending.pop_back();
+            if (!node->left) {
+                fn(std::string_view(node->text));
+                continue;
+            }
+            pending.push_back(node->right.get());
+            pending.push_back(node->left.get());
+        }
+    }
+
     using ValueVariant = std::variant<
         double,
         std::string,
         Closure,
         std::shared_ptr<NativeFunction>,
-        std::shared_ptr<List>
+        std::shared_ptr<List>,
+        std::shared_ptr<Stream>,
+        std::shared_ptr<Dict>,
+        std::shared_ptr<Rope>
     >;
 
     struct Value : ValueVariant {
@@ -51,6 +169,60 @@ namespace intp::interp {
         friend std::ostream &operator<<(std::ostream &os, const Value &value);
     };
 
+    template<typename F>
+    void List::for_each(F &&fn) const {
+        if (!numeric) {
+            for (const auto &element: elements) {
+                fn(element);
+            }
+            return;
+        }
+        floats.for_each_chunk([&](const std::span<const double> chunk) {
+            for (const double value: chunk) {
+                fn(Value{value});
+            }
+        });
+    }
+
+    /// Lazy sequence described by how its elements are produced, never by the elements themselves.
+    /// Every traversal pulls elements one at a time and keeps none of them, so pipelines over
+    /// unbounded ranges run in constant memory; to_list materializes a Stream that is read more than once.
+    struct Stream {
+        enum class Kind : uint8_t { Range, Iterate, Take, Filter, Map, DropWhile, Zip };
+
+        Kind kind;
+        double start = 0; /// Range start
+        double end = 0; /// Exclusive Range end or Take count
+        Value fn; /// Iterate step, Filter and DropWhile predicate or Map function
+        Value source; /// Iterate seed, List of Lists for Zip, otherwise the List or Stream read by every Kind but Range
+        std::shared_ptr<Env> env; /// Call site Environment fn is applied in
+
+        [[nodiscard]] std::string to_string() const;
+
+        friend std::ostream &operator<<(std::ostream &os, const Stream &stream);
+    };
+
+    /// Structural hash of a Dict key, -0.0 hashes like 0.0 and every NaN alike
+    struct ValueHash {
+        size_t operator()(const Value &value) const;
+    };
+
+    /// Dict keys are equal when both are equal Floats, both are NaN or both spell the same text.
+    /// NaN is one key however it was computed, otherwise a NaN key could never be looked up again.
+    struct ValueEq {
+        bool operator()(const Value &a, const Value &b) const;
+    };
+
+    /// Persistent map from Float or String keys to any Value.
+    /// dict_put returns a new Dict sharing every untouched node with its input.
+    struct Dict {
+        Hamt<Value, Value, ValueHash, ValueEq> entries;
+
+        [[nodiscard]] std::string to_string() const;
+
+        friend std::ostream &operator<<(std::ostream &os, const Dict &dict);
+    };
+
     struct ResultOptions {
         bool side_effects = false;
 
@@ -64,6 +236,7 @@ namespace intp::interp {
         int arity;
         std::string name;
         Impl impl;
+        std::atomic<uint64_t> *calls = stats::native_counter(name); /// Stats call counter, resolved once
 
         [[nodiscard]] std::string to_string() const;
 
@@ -73,14 +246,25 @@ namespace intp::interp {
     /// Lazy Thunk (call-by-need)
     struct Thunk : std::enable_shared_from_this<Thunk> {
         mutable std::optional<Value> cached;
-        const fe::ast::Expression *expr = nullptr; /// Non-owning, read-only AST pointer
-        std::unique_ptr<fe::ast::Expression> owned; /// Owning storage (when needed) (primarily in REPL)
+        const fe::ast::Arena *arena = nullptr; /// Non-owning, read-only AST storage
+        fe::ast::ExprId expr = 0;
+        std::shared_ptr<const fe::ast::Arena> owned; /// Keeps arena alive (when needed) (primarily in REPL)
         std::shared_ptr<Env> env; /// Environment for evaluating Expression
         std::optional<fe::loc::Loc> origin = std::nullopt;
+        /// Bound by a top-level definition with dependency tracking on.
+        /// Forcing a global Thunk records it as a dependent of every global Thunk read meanwhile.
+        bool global = false;
+        mutable uint32_t prune_dependents_at = 8; /// Size of dependents that triggers dropping expired entries
+        /// Global Thunks whose cached Value was computed from this one
+        mutable std::unordered_map<const Thunk *, std::weak_ptr<const Thunk> > dependents;
+        mutable const Thunk *last_reader = nullptr; /// Most recent entry of dependents
+        bool frozen = false; /// Part of a heap shared through intp::cow, reports its Value once computed
+
+        Thunk();
 
-        Thunk() = default;
+        ~Thunk();
 
-        Thunk(const fe::ast::Expression *expr, std::shared_ptr<Env> env,
+        Thunk(const fe::ast::Arena *arena, fe::ast::ExprId expr, std::shared_ptr<Env> env,
               std::optional<fe::loc::Loc> origin = std::nullopt);
 
         /// Force computation on Thunk and return a const reference to Value
@@ -88,31 +272,64 @@ namespace intp::interp {
 
         /// Sets Thunk's fields after construction
         /// Allows for recursive reference
-        void set(const fe::ast::Expression *expr_, std::shared_ptr<Env> env_,
+        void set(const fe::ast::Arena *arena_, fe::ast::ExprId expr_, std::shared_ptr<Env> env_,
                  std::optional<fe::loc::Loc> origin_ = std::nullopt);
 
-        void set_owned(fe::ast::Expression expr_, std::shared_ptr<Env> env_,
+        void set_owned(std::shared_ptr<const fe::ast::Arena> arena_, fe::ast::ExprId expr_, std::shared_ptr<Env> env_,
                        std::optional<fe::loc::Loc> origin_ = std::nullopt);
+
+        /// Record reader in dependents, dropping entries of readers that no longer exist as the table grows
+        void add_dependent(const Thunk *reader) const;
+
+        /// Drop the cached Values of every transitive dependent, returns how many were dropped
+        size_t invalidate_dependents() const;
     };
 
     struct Env : std::enable_shared_from_this<Env> {
         std::unordered_map<std::string, std::shared_ptr<Thunk> > table;
         std::shared_ptr<Env> parent;
+        bool frozen = false; /// Part of a heap shared through intp::cow
 
         explicit Env(std::shared_ptr<Env> parent = nullptr);
 
+        ~Env();
+
         std::shared_ptr<Thunk> lookup(const std::string &name) const;
 
+        /// Rebinding a global name invalidates the Values computed from the previous binding
         void bind(const std::string &name, std::shared_ptr<Thunk> thunk);
 
         std::vector<std::vector<std::string> > to_vector(bool force) const;
     };
 
-    Value eval_expr(const fe::ast::Expression &expr, std::shared_ptr<Env> env);
+    Value eval_expr(const fe::ast::Arena &arena, fe::ast::ExprId expr, std::shared_ptr<Env> env);
 
     Value apply_fn_apl(Value fn_value, const std::vector<std::shared_ptr<Thunk> > &args,
                        const std::shared_ptr<Env> &call_site_env,
-                       const std::optional<fe::loc::Loc> &call_loc = std::nullopt);
+                       const std::optional<fe::loc::Loc> &call_loc = std::nullopt, std::string_view callee = {});
+
+    /// Applies one function to a fixed number of arguments over and over, as folds do.
+    /// The argument Thunks and, for a curried lambda, its Environment frames are reused by the next call
+    /// whenever the previous one kept no reference to them, so a fold whose function captures nothing
+    /// allocates nothing per call. Natives of exactly that arity are called without apply_fn_apl.
+    class RepeatedCall {
+        Value fn;
+        std::shared_ptr<Env> call_site_env;
+        std::vector<std::shared_ptr<Thunk> > slots;
+        /// Parameters of a curried lambda taking every argument, empty for any other fn
+        std::vector<std::string> params;
+        fe::ast::ExprId body = 0; /// Body of the innermost lambda
+        std::vector<std::shared_ptr<Env> > frames; /// One per parameter, each binding its slot
+
+        /// True when nothing from a previous call still refers to a slot or frame
+        [[nodiscard]] bool reusable() const;
+
+    public:
+        RepeatedCall(Value fn, std::shared_ptr<Env> call_site_env, size_t arity);
+
+        /// fn applied to args, args.size() must equal the arity
+        Value operator()(std::span<Value> args);
+    };
 
     /// Program Driver
     struct Result {
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <lbd/fe/loc.h>
+
+/// Instrumenting profiler over lbd definitions and call sites, with a SIGPROF sampler where available.
+/// Recursive calls are folded into the nearest active frame of the same site, so the call tree stays
+/// bounded by the number of distinct sites instead of growing with recursion depth.
+namespace intp::profiler {
+    /// Checked by every Scope, the only cost while profiling is off
+    inline bool enabled = false;
+
+    /// Name the definition whose Expression starts at loc, used to label Thunk forcing frames
+    void name_definition(const fe::loc::Loc &loc, const std::string &name);
+
+    /// Clear previous results and start recording
+    void start();
+
+    void stop();
+
+    /// Flat per-site summary sorted by total time, at most limit rows (0 for all)
+    void report(std::ostream &os, size_t limit = 0);
+
+    /// Collapsed stacks ("frame;frame;frame self_us" per line, sorted) for flamegraph tools
+    void write_collapsed(std::ostream &os);
+
+    void enter_definition(const fe::loc::Loc &loc);
+
+    void enter_call(const std::optional<fe::loc::Loc> &loc, std::string_view name);
+
+    void leave();
+
+    /// RAII frame around forcing a global Thunk
+    struct DefinitionScope {
+        bool active;
+
+        explicit DefinitionScope(const std::optional<fe::loc::Loc> &origin) : active(enabled && origin) {
+            if (active) enter_definition(*origin);
+        }
+
+        ~DefinitionScope() {
+            if (active) leave();
+        }
+
+        DefinitionScope(const DefinitionScope &) = delete;
+
+        DefinitionScope &operator=(const DefinitionScope &) = delete;
+    };
+
+    /// RAII frame around a Function Application
+    struct CallScope {
+        bool active;
+
+        CallScope(const std::optional<fe::loc::Loc> &loc, const std::string_view name) : active(enabled) {
+            if (active) enter_call(loc, name);
+        }
+
+        ~CallScope() {
+            if (active) leave();
+        }
+
+        CallScope(const CallScope &) = delete;
+
+        CallScope &operator=(const CallScope &) = delete;
+    };
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+/// Float kernels over contiguous arrays.
+/// The implementation is picked once per process: AVX2, then SSE2, then portable scalar loops.
+/// Setting the LBD_SIMD environment variable to sse2 or scalar caps the choice.
+/// Reductions reassociate additions and multiplications, so results may differ from a fold in the last bits.
+namespace intp::simd {
+    double sum(const double *x, size_t n);
+
+    double product(const double *x, size_t n);
+
+    /// n must be at least 1. NaN when any element is NaN, on every instruction set
+    double min(const double *x, size_t n);
+
+    /// n must be at least 1. NaN when any element is NaN, on every instruction set
+    double max(const double *x, size_t n);
+
+    double dot(const double *x, const double *y, size_t n);
+
+    /// out[i] = x[i] + y[i], out may alias x or y
+    void add(const double *x, const double *y, double *out, size_t n);
+
+    void sub(const double *x, const double *y, double *out, size_t n);
+
+    void mul(const double *x, const double *y, double *out, size_t n);
+
+    /// out[i] = k * x[i], out may alias x
+    void scale(double k, const double *x, double *out, size_t n);
+
+    /// Instruction set in use: "avx2", "sse2" or "scalar"
+    const char *isa();
+}
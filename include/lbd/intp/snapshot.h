@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <lbd/fe/ast.h>
+#include <lbd/intp/interpreter.h>
+#include <lbd/options.h>
+
+namespace intp::snapshot {
+    /// Restored state of a heap snapshot
+    struct Image {
+        std::shared_ptr<interp::Env> global_env;
+        std::vector<std::shared_ptr<const fe::ast::Arena> > arenas; /// Owns the AST restored Thunks point into
+        std::unordered_set<std::string> loaded_files; /// Files pulled in through `use` before the snapshot
+    };
+
+    /// Serialize the global Environment reachable from global_env, including forced Thunk values and every
+    /// Arena referenced by a Thunk or Closure
+    void save(const std::string &filepath, const std::shared_ptr<interp::Env> &global_env,
+              const std::unordered_set<std::string> &loaded_files, options::Options options_ = {});
+
+    /// Restore a heap snapshot written by save, Native Functions are resolved by name against the builtins
+    Image load(const std::string &filepath, options::Options options_ = {});
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+
+/// Interpreter operation counters. Every hook is a macro so that defining LBD_DISABLE_STATS
+/// (done for Release builds) compiles them out together with the operator new accounting.
+/// Allocations are only counted by executables that link src/alloc_count.cpp, embedders see zero.
+namespace intp::stats {
+#if defined(LBD_DISABLE_STATS)
+    inline constexpr bool compiled_in = false;
+#else
+    inline constexpr bool compiled_in = true;
+#endif
+
+    /// Bumped from the evaluating thread as well as from parser and sort workers, so every counter is a relaxed atomic
+    struct Counters {
+        std::atomic<uint64_t> thunks_created = 0;
+        std::atomic<uint64_t> thunks_forced = 0;
+        std::atomic<uint64_t> thunk_cache_hits = 0;
+        std::atomic<uint64_t> env_frames = 0;
+        std::atomic<uint64_t> closure_applications = 0;
+        std::atomic<uint64_t> native_calls = 0;
+        std::atomic<uint64_t> peak_depth = 0;
+        std::atomic<uint64_t> allocations = 0;
+        std::atomic<uint64_t> bytes_allocated = 0;
+    };
+
+    inline Counters counters;
+
+    /// Evaluation depth of the current thread
+    inline thread_local uint64_t depth = 0;
+
+    /// Plain copy of the counters, for comparing before and after a workload
+    struct Snapshot {
+        uint64_t thunks_created;
+        uint64_t thunks_forced;
+        uint64_t thunk_cache_hits;
+        uint64_t env_frames;
+        uint64_t closure_applications;
+        uint64_t native_calls;
+        std::map<std::string, uint64_t> native_calls_by_name;
+        uint64_t peak_depth;
+        uint64_t allocations;
+        uint64_t bytes_allocated;
+    };
+
+    Snapshot snapshot();
+
+    void reset();
+
+    /// Human readable summary
+    void report(std::ostream &os);
+
+    void write_json(std::ostream &os);
+
+    /// Call counter of the native function called name, which lives as long as the process.
+    /// Looked up once per NativeFunction, so a call only bumps the counter. Null when stats are compiled out.
+    std::atomic<uint64_t> *native_counter(std::string_view name);
+
+    inline void native_call(std::atomic<uint64_t> *calls) {
+        counters.native_calls.fetch_add(1, std::memory_order_relaxed);
+        calls->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// RAII evaluation depth tracking
+    struct DepthScope {
+        DepthScope() {
+            const uint64_t current = ++depth;
+            uint64_t peak = counters.peak_depth.load(std::memory_order_relaxed);
+            while (current > peak && !counters.peak_depth.compare_exchange_weak(peak, current,
+                                                                                std::memory_order_relaxed)) {
+            }
+        }
+
+        ~DepthScope() {
+            --depth;
+        }
+
+        DepthScope(const DepthScope &) = delete;
+
+        DepthScope &operator=(const DepthScope &) = delete;
+    };
+}
+
+#if defined(LBD_DISABLE_STATS)
+#define LBD_STAT_INC(counter) ((void)0)
+#define LBD_STAT_NATIVE_CALL(calls) ((void)0)
+#define LBD_STAT_DEPTH_SCOPE() ((void)0)
+#else
+#define LBD_STAT_INC(counter) (::intp::stats::counters.counter.fetch_add(1, std::memory_order_relaxed))
+#define LBD_STAT_NATIVE_CALL(calls) (::intp::stats::native_call(calls))
+#define LBD_STAT_DEPTH_SCOPE() const ::intp::stats::DepthScope lbd_stat_depth_scope_
+#endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <optional>
+#include <sstream>
+#include <string>
 #include <lbd/fe/loc.h>
 #include <lbd/utils/term.h>
 #include <lbd/exceptions.h>
@@ -10,6 +12,9 @@ namespace logs {
         bool exit_on_error = true;
         bool use_color = false;
         bool show_loc = true;
+        /// When set, error() stores its diagnostic here and throws ControlledExit instead of printing or exiting.
+        /// Lets worker threads hand their diagnostic to the thread that joins them.
+        std::string *capture = nullptr;
 
         Logger() = default;
 
@@ -22,6 +27,15 @@ namespace logs {
 
         template<typename... Args>
         [[noreturn]] void error(const std::optional<fe::loc::Loc> &loc, Args &&... args) const {
+            if (capture) {
+                std::ostringstream os;
+                if (show_loc && loc.has_value()) {
+                    os << loc.value() << ": ";
+                }
+                (os << ... << std::forward<Args>(args));
+                *capture = os.str();
+                throw ControlledExit{};
+            }
             if (use_color) {
                 std::cerr << colors::RED;
             }
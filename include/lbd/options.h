@@ -7,5 +7,9 @@ namespace options {
         bool force_on_env_dump = false;
         bool debug = false;
         logs::Logger logger;
+        bool module_cache = true; /// Reuse parsed `use` files from the on-disk module cache
+        bool track_dependencies = false; /// Invalidate values computed from a redefined binding. Turned on for REPL
+        /// Fuse `(map f xs)` arguments into their consumer, so f runs interleaved with it. Turned on by --fuse
+        bool fuse_maps = false;
     };
 }
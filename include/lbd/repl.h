@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <lbd/intp/interpreter.h>
+
 namespace repl {
-    void loop(bool debug = false);
+    void loop(bool debug = false, std::shared_ptr<intp::interp::Env> initial_env = nullptr);
 }
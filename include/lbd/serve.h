@@ -0,0 +1,47 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+/// Evaluation server protocol (one request per connection):
+///   request:  <kind byte> <payload...> then the client shuts down its write side
+///   response: <status byte> <captured output...> then the server closes the connection
+namespace serve {
+    constexpr char REQUEST_EXPR = 'e'; /// Payload is source text, evaluated like a REPL line
+    constexpr char REQUEST_FILE = 'f'; /// Payload is an absolute filepath to run
+
+    constexpr char STATUS_OK = '0';
+    constexpr char STATUS_ERROR = '1';
+
+    /// Load the prelude once, then serve requests until the process is terminated
+    int run(const std::string &socket_path, const std::optional<std::string> &prelude, bool debug = false);
+
+#if !defined(_WIN32)
+    inline bool write_all(const int fd, const std::string &data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            const ssize_t n = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            written += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    inline std::string read_all(const int fd) {
+        std::string data;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+            data.append(buffer, static_cast<size_t>(n));
+        }
+        return data;
+    }
+#endif
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/// Persistent (immutable) hash map, a hash array mapped trie with structural sharing.
+/// Every node consumes 5 bits of the hash and keeps entries and children in separate bitmaps,
+/// so lookups and inserts are O(log32 n) and an insert copies only the nodes on its path.
+template<typename K, typename V, typename Hash = std::hash<K>, typename Eq = std::equal_to<K> >
+class Hamt {
+    struct Entry {
+        size_t hash;
+        K key;
+        V value;
+    };
+
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node {
+        uint32_t datamap = 0; /// Slots holding an Entry
+        uint32_t nodemap = 0; /// Slots holding a child Node
+        std::vector<Entry> entries; /// In slot order, or unordered in a collision Node
+        std::vector<NodePtr> children; /// In slot order
+    };
+
+    static constexpr unsigned BITS = 5;
+    static constexpr unsigned HASH_BITS = sizeof(size_t) * 8;
+
+    NodePtr root;
+    size_t count = 0;
+
+    Hamt(NodePtr root, const size_t count) : root(std::move(root)), count(count) {
+    }
+
+    static uint32_t slot_bit(const size_t hash, const unsigned shift) {
+        return uint32_t{1} << (hash >> shift & 31);
+    }
+
+    static size_t index_of(const uint32_t map, const uint32_t bit) {
+        return static_cast<size_t>(std::popcount(map & (bit - 1)));
+    }
+
+    /// Node holding two entries whose hashes agree below shift
+    static NodePtr make_pair(Entry a, Entry b, const unsigned shift) {
+        Node node;
+        if (shift >= HASH_BITS) {
+            // Full hash collision, entries are told apart by Eq only
+            node.entries = {std::move(a), std::move(b)};
+            return std::make_shared<const Node>(std::move(node));
+        }
+        const uint32_t bit_a = slot_bit(a.hash, shift);
+        const uint32_t bit_b = slot_bit(b.hash, shift);
+        if (bit_a == bit_b) {
+            node.nodemap = bit_a;
+            node.children.push_back(make_pair(std::move(a), std::move(b), shift + BITS));
+        } else {
+            node.datamap = bit_a | bit_b;
+            if (bit_a < bit_b) {
+                node.entries = {std::move(a), std::move(b)};
+            } else {
+                node.entries = {std::move(b), std::move(a)};
+            }
+        }
+        return std::make_shared<const Node>(std::move(node));
+    }
+
+    static NodePtr insert(const NodePtr &node, Entry entry, const unsigned shift, bool &added) {
+        if (!node) {
+            added = true;
+            Node leaf;
+            leaf.datamap = slot_bit(entry.hash, shift);
+            leaf.entries.push_back(std::move(entry));
+            return std::make_shared<const Node>(std::move(leaf));
+        }
+        Node copy = *node;
+        if (shift >= HASH_BITS) {
+            for (auto &existing: copy.entries) {
+                if (Eq{}(existing.key, entry.key)) {
+                    existing.value = std::move(entry.value);
+                    return std::make_shared<const Node>(std::move(copy));
+                }
+            }
+            added = true;
+            copy.entries.push_back(std::move(entry));
+            return std::make_shared<const Node>(std::move(copy));
+        }
+        const uint32_t bit = slot_bit(entry.hash, shift);
+        if (copy.datamap & bit) {
+            const size_t i = index_of(copy.datamap, bit);
+            if (copy.entries[i].hash == entry.hash && Eq{}(copy.entries[i].key, entry.key)) {
+                copy.entries[i].value = std::move(entry.value);
+                return std::make_shared<const Node>(std::move(copy));
+            }
+            // Push the resident entry down into a child together with the new one
+            added = true;
+            NodePtr child = make_pair(std::move(copy.entries[i]), std::move(entry), shift + BITS);
+            copy.entries.erase(copy.entries.begin() + static_cast<std::ptrdiff_t>(i));
+            copy.datamap &= ~bit;
+            copy.nodemap |= bit;
+            copy.children.insert(copy.children.begin() + static_cast<std::ptrdiff_t>(index_of(copy.nodemap, bit)),
+                                 std::move(child));
+        } else if (copy.nodemap & bit) {
+            NodePtr &child = copy.children[index_of(copy.nodemap, bit)];
+            child = insert(child, std::move(entry), shift + BITS, added);
+        } else {
+            added = true;
+            copy.datamap |= bit;
+            copy.entries.insert(copy.entries.begin() + static_cast<std::ptrdiff_t>(index_of(copy.datamap, bit)),
+                                std::move(entry));
+        }
+        return std::make_shared<const Node>(std::move(copy));
+    }
+
+    template<typename F>
+    static void for_each(const NodePtr &node, F &fn) {
+        if (!node) return;
+        for (const auto &entry: node->entries) {
+            fn(entry.key, entry.value);
+        }
+        for (const auto &child: node->children) {
+            for_each(child, fn);
+        }
+    }
+
+public:
+    Hamt() = default;
+
+    [[nodiscard]] size_t size() const {
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return count == 0;
+    }
+
+    /// Value bound to key or nullptr
+    [[nodiscard]] const V *find(const K &key) const {
+        const size_t hash = Hash{}(key);
+        const Node *node = root.get();
+        for (unsigned shift = 0; node; shift += BITS) {
+            if (shift >= HASH_BITS) {
+                for (const auto &entry: node->entries) {
+                    if (Eq{}(entry.key, key)) return &entry.value;
+                }
+                return nullptr;
+            }
+            const uint32_t bit = slot_bit(hash, shift);
+            if (node->datamap & bit) {
+                const Entry &entry = node->entries[index_of(node->datamap, bit)];
+                return entry.hash == hash && Eq{}(entry.key, key) ? &entry.value : nullptr;
+            }
+            if (!(node->nodemap & bit)) return nullptr;
+            node = node->children[index_of(node->nodemap, bit)].get();
+        }
+        return nullptr;
+    }
+
+    /// Copy with key bound to value, replacing any previous binding
+    [[nodiscard]] Hamt insert(K key, V value) const {
+        bool added = false;
+        const size_t hash = Hash{}(key);
+        NodePtr new_root = insert(root, Entry{hash, std::move(key), std::move(value)}, 0, added);
+        return Hamt(std::move(new_root), count + (added ? 1 : 0));
+    }
+
+    /// Calls fn(key, value) for every binding, in an order fixed by the hashes
+    template<typename F>
+    void for_each(F &&fn) const {
+        for_each(root, fn);
+    }
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Read-only memory mapping of a whole file, falls back to reading it into memory where mmap is unavailable.
+/// On failure `error` describes what went wrong and the contents are empty.
+struct MappedFile {
+    const char *data = nullptr;
+    size_t size = 0;
+    const char *error = nullptr;
+#if defined(_WIN32)
+    std::string contents;
+#else
+    void *mapping = MAP_FAILED;
+#endif
+
+    explicit MappedFile(const std::string &filepath) {
+#if defined(_WIN32)
+        std::ifstream ifs(filepath, std::ios::in | std::ios::binary);
+        if (!ifs) {
+            error = "could not open file";
+            return;
+        }
+        contents.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        data = contents.data();
+        size = contents.size();
+#else
+        const int fd = ::open(filepath.c_str(), O_RDONLY);
+        struct stat st{};
+        if (fd < 0 || ::fstat(fd, &st) < 0) {
+            if (fd >= 0) ::close(fd);
+            error = "could not open file";
+            return;
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (size > 0) {
+            mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (size > 0 && mapping == MAP_FAILED) {
+            error = "could not map file";
+            size = 0;
+            return;
+        }
+        data = mapping == MAP_FAILED ? nullptr : static_cast<const char *>(mapping);
+#endif
+    }
+
+    ~MappedFile() {
+#if !defined(_WIN32)
+        if (mapping != MAP_FAILED) {
+            ::munmap(mapping, size);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]] std::string_view view() const {
+        return {data, size};
+    }
+};
@@ -0,0 +1,382 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+/// Persistent (immutable) vector with structural sharing.
+/// Elements live in leaf chunks of up to CHUNK values under an AVL-balanced tree of concatenations,
+/// so indexing, push_back, set, split and concat are O(log n) and only copy the path they touch.
+template<typename T>
+class PVector {
+    struct Node {
+        size_t size;
+        uint8_t height; /// Leaves are 0
+        std::shared_ptr<const Node> left; /// Internal nodes only, never null there
+        std::shared_ptr<const Node> right;
+        std::vector<T> values; /// Leaves only
+    };
+
+    using NodePtr = std::shared_ptr<const Node>;
+
+    NodePtr root;
+
+    explicit PVector(NodePtr root) : root(std::move(root)) {
+    }
+
+    static size_t size_of(const NodePtr &node) {
+        return node ? node->size : 0;
+    }
+
+    static int height_of(const NodePtr &node) {
+        return node ? node->height : -1;
+    }
+
+    static NodePtr make_leaf(std::vector<T> values) {
+        if (values.empty()) {
+            return nullptr;
+        }
+        const size_t size = values.size();
+        return std::make_shared<const Node>(Node{size, 0, nullptr, nullptr, std::move(values)});
+    }
+
+    static NodePtr make_node(NodePtr left, NodePtr right) {
+        const size_t size = left->size + right->size;
+        const auto height = static_cast<uint8_t>(std::max(left->height, right->height) + 1);
+        return std::make_shared<const Node>(Node{size, height, std::move(left), std::move(right), {}});
+    }
+
+    static NodePtr rotate_left(const NodePtr &node) {
+        const NodePtr &r = node->right;
+        return make_node(make_node(node->left, r->left), r->right);
+    }
+
+    static NodePtr rotate_right(const NodePtr &node) {
+        const NodePtr &l = node->left;
+        return make_node(l->left, make_node(l->right, node->right));
+    }
+
+    /// Node of two subtrees whose heights differ by at most 2
+    static NodePtr balance(NodePtr left, NodePtr right) {
+        if (height_of(right) > height_of(left) + 1) {
+            if (height_of(right->left) > height_of(right->right)) {
+                right = rotate_right(right);
+            }
+            return rotate_left(make_node(std::move(left), std::move(right)));
+        }
+        if (height_of(left) > height_of(right) + 1) {
+            if (height_of(left->right) > height_of(left->left)) {
+                left = rotate_left(left);
+            }
+            return rotate_right(make_node(std::move(left), std::move(right)));
+        }
+        return make_node(std::move(left), std::move(right));
+    }
+
+    // Join of a taller left tree with a shorter right tree, descending the right spine
+    static NodePtr join_right(const NodePtr &tl, const NodePtr &tr) {
+        if (height_of(tl->right) <= height_of(tr) + 1) {
+            return balance(tl->left, make_node(tl->right, tr));
+        }
+        return balance(tl->left, join_right(tl->right, tr));
+    }
+
+    static NodePtr join_left(const NodePtr &tl, const NodePtr &tr) {
+        if (height_of(tr->left) <= height_of(tl) + 1) {
+            return balance(make_node(tl, tr->left), tr->right);
+        }
+        return balance(join_left(tl, tr->left), tr->right);
+    }
+
+    static NodePtr join(const NodePtr &a, const NodePtr &b) {
+        if (!a) return b;
+        if (!b) return a;
+        if (a->height == 0 && b->height == 0 && a->size + b->size <= CHUNK) {
+            std::vector<T> values;
+            values.reserve(a->size + b->size);
+            values.insert(values.end(), a->values.begin(), a->values.end());
+            values.insert(values.end(), b->values.begin(), b->values.end());
+            return make_leaf(std::move(values));
+        }
+        if (a->height > b->height + 1) return join_right(a, b);
+        if (b->height > a->height + 1) return join_left(a, b);
+        return make_node(a, b);
+    }
+
+    /// First index elements and the rest
+    static std::pair<NodePtr, NodePtr> split(const NodePtr &node, const size_t index) {
+        if (!node || index == 0) return {nullptr, node};
+        if (index >= node->size) return {node, nullptr};
+        if (node->height == 0) {
+            const auto mid = node->values.begin() + static_cast<std::ptrdiff_t>(index);
+            return {
+                make_leaf(std::vector<T>(node->values.begin(), mid)),
+                make_leaf(std::vector<T>(mid, node->values.end()))
+            };
+        }
+        if (index < node->left->size) {
+            auto [ll, lr] = split(node->left, index);
+            return {std::move(ll), join(lr, node->right)};
+        }
+        auto [rl, rr] = split(node->right, index - node->left->size);
+        return {join(node->left, rl), std::move(rr)};
+    }
+
+    static NodePtr append(const NodePtr &node, T value) {
+        if (!node) {
+            return make_leaf(std::vector<T>{std::move(value)});
+        }
+        if (node->height == 0) {
+            if (node->size < CHUNK) {
+                std::vector<T> values;
+                values.reserve(node->size + 1);
+                values.insert(values.end(), node->values.begin(), node->values.end());
+                values.push_back(std::move(value));
+                return make_leaf(std::move(values));
+            }
+            return make_node(node, make_leaf(std::vector<T>{std::move(value)}));
+        }
+        return balance(node->left, append(node->right, std::move(value)));
+    }
+
+    static NodePtr assign(const NodePtr &node, const size_t index, T value) {
+        if (node->height == 0) {
+            std::vector<T> values = node->values;
+            values[index] = std::move(value);
+            return make_leaf(std::move(values));
+        }
+        if (index < node->left->size) {
+            return make_node(assign(node->left, index, std::move(value)), node->right);
+        }
+        return make_node(node->left, assign(node->right, index - node->left->size, std::move(value)));
+    }
+
+    /// Perfectly balanced tree over chunks [begin, end)
+    static NodePtr build(std::vector<NodePtr> &leaves, const size_t begin, const size_t end) {
+        if (end - begin == 1) {
+            return leaves[begin];
+        }
+        const size_t mid = begin + (end - begin) / 2;
+        return make_node(build(leaves, begin, mid), build(leaves, mid, end));
+    }
+
+    /// Leaf holding element index, and the index of its first element
+    const Node *leaf_at(size_t index, size_t &leaf_begin) const {
+        const Node *node = root.get();
+        leaf_begin = 0;
+        while (node->height != 0) {
+            if (index < node->left->size) {
+                node = node->left.get();
+            } else {
+                index -= node->left->size;
+                leaf_begin += node->left->size;
+                node = node->right.get();
+            }
+        }
+        return node;
+    }
+
+    template<typename F>
+    static void for_each_chunk(const NodePtr &node, F &fn) {
+        if (!node) return;
+        if (node->height == 0) {
+            fn(std::span<const T>(node->values));
+            return;
+        }
+        for_each_chunk(node->left, fn);
+        for_each_chunk(node->right, fn);
+    }
+
+public:
+    static constexpr size_t CHUNK = 32;
+
+    class const_iterator {
+        const PVector *vec = nullptr;
+        size_t index = 0;
+        const T *leaf_data = nullptr;
+        size_t leaf_begin = 0;
+        size_t leaf_end = 0;
+
+        void load() {
+            if (index - leaf_begin < leaf_end - leaf_begin || index >= vec->size()) return;
+            const Node *leaf = vec->leaf_at(index, leaf_begin);
+            leaf_data = leaf->values.data();
+            leaf_end = leaf_begin + leaf->size;
+        }
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T *;
+        using reference = const T &;
+
+        const_iterator() = default;
+
+        const_iterator(const PVector *vec, const size_t index) : vec(vec), index(index) {
+            load();
+        }
+
+        reference operator*() const {
+            return leaf_data[index - leaf_begin];
+        }
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        const_iterator &operator++() {
+            ++index;
+            load();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        const_iterator &operator--() {
+            --index;
+            load();
+            return *this;
+        }
+
+        const_iterator operator--(int) {
+            const_iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        bool operator==(const const_iterator &other) const {
+            return index == other.index;
+        }
+    };
+
+    using value_type = T;
+    using iterator = const_iterator;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    PVector() = default;
+
+    explicit PVector(std::vector<T> values) {
+        if (values.empty()) return;
+        if (values.size() <= CHUNK) {
+            root = make_leaf(std::move(values));
+            return;
+        }
+        std::vector<NodePtr> leaves;
+        leaves.reserve((values.size() + CHUNK - 1) / CHUNK);
+        for (size_t i = 0; i < values.size(); i += CHUNK) {
+            const auto first = values.begin() + static_cast<std::ptrdiff_t>(i);
+            const auto last = values.begin() + static_cast<std::ptrdiff_t>(std::min(values.size(), i + CHUNK));
+            leaves.push_back(make_leaf(std::vector<T>(std::make_move_iterator(first), std::make_move_iterator(last))));
+        }
+        root = build(leaves, 0, leaves.size());
+    }
+
+    [[nodiscard]] size_t size() const {
+        return size_of(root);
+    }
+
+    [[nodiscard]] bool empty() const {
+        return !root;
+    }
+
+    const T &operator[](const size_t index) const {
+        size_t leaf_begin;
+        return leaf_at(index, leaf_begin)->values[index - leaf_begin];
+    }
+
+    [[nodiscard]] PVector push_back(T value) const {
+        return PVector(append(root, std::move(value)));
+    }
+
+    /// Copy with the element at index replaced, index must be in range
+    [[nodiscard]] PVector set(const size_t index, T value) const {
+        return PVector(assign(root, index, std::move(value)));
+    }
+
+    /// Copy without the element at index, index must be in range
+    [[nodiscard]] PVector erase(const size_t index) const {
+        auto [head, rest] = split(root, index);
+        return PVector(join(head, split(rest, 1).second));
+    }
+
+    /// Elements [begin, end), clamped to the size
+    [[nodiscard]] PVector slice(const size_t begin, const size_t end) const {
+        if (begin >= end) return {};
+        return PVector(split(split(root, end).first, begin).second);
+    }
+
+    [[nodiscard]] static PVector concat(const PVector &a, const PVector &b) {
+        return PVector(join(a.root, b.root));
+    }
+
+    /// Calls fn with each leaf chunk as a contiguous std::span<const T>, in order
+    template<typename F>
+    void for_each_chunk(F &&fn) const {
+        for_each_chunk(root, fn);
+    }
+
+    /// Index of the first element for which pred is false, the elements must be partitioned by pred.
+    /// Descends by the last element of every left subtree, then halves the leaf without branching on pred.
+    template<typename Pred>
+    [[nodiscard]] size_t partition_point(Pred pred) const {
+        const Node *node = root.get();
+        if (!node) return 0;
+        size_t leaf_begin = 0;
+        while (node->height != 0) {
+            const Node *last = node->left.get();
+            while (last->height != 0) {
+                last = last->right.get();
+            }
+            if (pred(last->values.back())) {
+                leaf_begin += node->left->size;
+                node = node->right.get();
+            } else {
+                node = node->left.get();
+            }
+        }
+        const T *first = node->values.data();
+        const T *base = first;
+        size_t n = node->values.size();
+        while (n > 1) {
+            const size_t half = n / 2;
+            base = pred(base[half]) ? base + half : base;
+            n -= half;
+        }
+        return leaf_begin + static_cast<size_t>(base - first) + (pred(*base) ? 1 : 0);
+    }
+
+    [[nodiscard]] std::vector<T> to_vector() const {
+        std::vector<T> values;
+        values.reserve(size());
+        for_each_chunk([&](const std::span<const T> chunk) {
+            values.insert(values.end(), chunk.begin(), chunk.end());
+        });
+        return values;
+    }
+
+    [[nodiscard]] const_iterator begin() const {
+        return {this, 0};
+    }
+
+    [[nodiscard]] const_iterator end() const {
+        return {this, size()};
+    }
+
+    [[nodiscard]] const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    [[nodiscard]] const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+};
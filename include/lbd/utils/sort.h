@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/// Key whose unsigned order is the total order of IEEE-754 doubles:
+/// -0.0 before 0.0, negative NaNs before everything and positive NaNs after everything
+inline uint64_t float_order_key(const double value) {
+    // Flipping the sign bit of positives and every bit of negatives makes unsigned order match numeric order
+    const auto bits = std::bit_cast<uint64_t>(value);
+    return bits >> 63 ? ~bits : bits | (uint64_t{1} << 63);
+}
+
+/// Strict weak ordering of doubles by float_order_key, safe for std::sort even with NaNs
+inline bool float_order_less(const double a, const double b) {
+    return float_order_key(a) < float_order_key(b);
+}
+
+/// Ascending LSD radix sort on float_order_key, one byte per pass, so it orders like float_order_less
+inline void radix_sort(std::vector<double> &values) {
+    const size_t n = values.size();
+    std::vector<uint64_t> keys(n), scratch(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = float_order_key(values[i]);
+    }
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        std::array<size_t, 257> offsets{};
+        for (const uint64_t key: keys) {
+            ++offsets[(key >> shift & 0xff) + 1];
+        }
+        // Every key shares this byte, the pass would not move anything
+        if (std::ranges::find(offsets, n) != offsets.end()) continue;
+        for (size_t b = 1; b < offsets.size(); ++b) {
+            offsets[b] += offsets[b - 1];
+        }
+        for (const uint64_t key: keys) {
+            scratch[offsets[key >> shift & 0xff]++] = key;
+        }
+        keys.swap(scratch);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = keys[i];
+        values[i] = std::bit_cast<double>(key >> 63 ? key & ~(uint64_t{1} << 63) : ~key);
+    }
+}
+
+/// Merge kernels over ascending Float ranges with multiset semantics, as std::set_intersection and friends.
+/// Every step advances by comparison results instead of branching on them, so unpredictable inputs
+/// do not stall on mispredictions. Elements compare by float_order_less, the order sort produces.
+inline std::vector<double> merge_intersect(const std::vector<double> &x, const std::vector<double> &y) {
+    std::vector<double> out(std::min(x.size(), y.size()));
+    size_t i = 0, j = 0, k = 0;
+    while (i < x.size() && j < y.size() && k < out.size()) {
+        const double a = x[i], b = y[j];
+        const bool lt = float_order_less(a, b), gt = float_order_less(b, a);
+        out[k] = a;
+        k += !lt & !gt;
+        i += !gt;
+        j += !lt;
+    }
+    out.resize(k);
+    return out;
+}
+
+inline std::vector<double> merge_union(const std::vector<double> &x, const std::vector<double> &y) {
+    std::vector<double> out(x.size() + y.size());
+    size_t i = 0, j = 0, k = 0;
+    while (i < x.size() && j < y.size()) {
+        const double a = x[i], b = y[j];
+        const bool lt = float_order_less(a, b), gt = float_order_less(b, a);
+        out[k++] = gt ? b : a;
+        i += !gt;
+        j += !lt;
+    }
+    k = static_cast<size_t>(std::copy(x.begin() + static_cast<std::ptrdiff_t>(i), x.end(),
+                                      out.begin() + static_cast<std::ptrdiff_t>(k)) - out.begin());
+    k = static_cast<size_t>(std::copy(y.begin() + static_cast<std::ptrdiff_t>(j), y.end(),
+                                      out.begin() + static_cast<std::ptrdiff_t>(k)) - out.begin());
+    out.resize(k);
+    return out;
+}
+
+inline std::vector<double> merge_difference(const std::vector<double> &x, const std::vector<double> &y) {
+    std::vector<double> out(x.size());
+    size_t i = 0, j = 0, k = 0;
+    while (i < x.size() && j < y.size()) {
+        const double a = x[i], b = y[j];
+        const bool lt = float_order_less(a, b), gt = float_order_less(b, a);
+        out[k] = a;
+        k += lt;
+        i += !gt;
+        j += !lt;
+    }
+    k = static_cast<size_t>(std::copy(x.begin() + static_cast<std::ptrdiff_t>(i), x.end(),
+                                      out.begin() + static_cast<std::ptrdiff_t>(k)) - out.begin());
+    out.resize(k);
+    return out;
+}
+
+/// Drops every element with the float_order_key of the last one kept, in place and without branching on the comparison
+inline void dedupe_adjacent(std::vector<double> &values) {
+    if (values.empty()) return;
+    size_t k = 1;
+    for (size_t i = 1; i < values.size(); ++i) {
+        values[k] = values[i];
+        k += float_order_key(values[i]) != float_order_key(values[k - 1]);
+    }
+    values.resize(k);
+}
+
+/// Stable sort of runs on separate threads followed by rounds of pairwise merges, also on separate threads.
+/// less must be safe to call concurrently, small inputs or a single core fall back to std::stable_sort.
+template<typename T, typename Less>
+void parallel_stable_sort(std::vector<T> &values, Less less, const size_t min_parallel = size_t{1} << 14) {
+    const size_t n = values.size();
+    const size_t workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                            n / std::max<size_t>(min_parallel / 4, 1));
+    if (n < min_parallel || workers <= 1) {
+        std::stable_sort(values.begin(), values.end(), less);
+        return;
+    }
+    std::vector<size_t> bounds(workers + 1);
+    for (size_t w = 0; w <= workers; ++w) {
+        bounds[w] = n * w / workers;
+    }
+    const auto at = [&](const size_t i) {
+        return values.begin() + static_cast<std::ptrdiff_t>(i);
+    };
+    {
+        std::vector<std::jthread> threads;
+        for (size_t w = 0; w < workers; ++w) {
+            threads.emplace_back([&, w] {
+                std::stable_sort(at(bounds[w]), at(bounds[w + 1]), less);
+            });
+        }
+    }
+    // Merging neighbouring runs keeps equal elements in their original order
+    while (bounds.size() > 2) {
+        std::vector<size_t> merged;
+        {
+            std::vector<std::jthread> threads;
+            for (size_t r = 0; r + 2 < bounds.size(); r += 2) {
+                threads.emplace_back([&, r] {
+                    std::inplace_merge(at(bounds[r]), at(bounds[r + 1]), at(bounds[r + 2]), less);
+                });
+            }
+        }
+        for (size_t r = 0; r < bounds.size(); r += 2) {
+            merged.push_back(bounds[r]);
+        }
+        if (merged.back() != n) {
+            merged.push_back(n);
+        }
+        bounds = std::move(merged);
+    }
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 
 inline std::string escape(const std::string& str) {
     std::string result;
@@ -27,7 +28,7 @@ inline std::string escape(const std::string& str) {
     return result;
 }
 
-inline std::string unescape_string(const std::string &str) {
+inline std::string unescape_string(const std::string_view str) {
     std::string result;
     result.reserve(str.size());
     for (size_t i = 0; i < str.size(); ++i) {
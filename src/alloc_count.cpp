@@ -0,0 +1,59 @@
+#include <cstdlib>
+#include <new>
+#include <lbd/intp/stats.h>
+
+// Counts every allocation of the process into intp::stats, including those made by the standard library.
+// Replacing the global operator new is a whole-program decision, so this file is linked into our executables
+// only and never into libintp, which embedders link into their own programs.
+// Optimized builds leave it out with the other stats, unless the executable asks for LBD_COUNT_ALLOCATIONS.
+#if !defined(LBD_DISABLE_STATS) || defined(LBD_COUNT_ALLOCATIONS)
+void *operator new(const std::size_t size) {
+    intp::stats::counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    intp::stats::counters.bytes_allocated.fetch_add(size, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](const std::size_t size) {
+    return operator new(size);
+}
+
+// The nothrow forms must come from the same allocator as the plain operator delete that frees them
+void *operator new(const std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return operator new(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](const std::size_t size, const std::nothrow_t &) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+#endif
@@ -0,0 +1,70 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <lbd/serve.h>
+
+#if !defined(_WIN32)
+#include <sys/un.h>
+#endif
+
+// Local client for `lbd --serve`, sends a single request and prints the response
+
+static void print_help(std::ostream &os, const std::string &program_name) {
+    os << "usage: " << program_name << " <socket> (-e <expr> | -f <filepath>)\n\n"
+            << "options:\n"
+            << "  -e, --expr <expr>       Evaluate expression against the warm environment\n"
+            << "  -f, --file <filepath>   Run source file against the warm environment" << std::endl;
+}
+
+int main(const int argc, char **argv) {
+    if (argc != 4) {
+        print_help(std::cerr, argv[0]);
+        return EXIT_FAILURE;
+    }
+#if defined(_WIN32)
+    std::cerr << "error: Unix domain sockets are not supported on this platform" << std::endl;
+    return EXIT_FAILURE;
+#else
+    const std::string socket_path = argv[1];
+    const std::string flag = argv[2];
+    std::string request;
+    if (flag == "-e" || flag == "--expr") {
+        request = serve::REQUEST_EXPR + std::string(argv[3]);
+    } else if (flag == "-f" || flag == "--file") {
+        // Server may run from a different working directory
+        request = serve::REQUEST_FILE + std::filesystem::absolute(argv[3]).string();
+    } else {
+        std::cerr << "unknown option: " << flag << "\n";
+        print_help(std::cerr, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "error: socket path too long " << socket_path << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::copy(socket_path.begin(), socket_path.end(), addr.sun_path);
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        std::perror("connect");
+        return EXIT_FAILURE;
+    }
+    if (!serve::write_all(fd, request)) {
+        std::perror("send");
+        ::close(fd);
+        return EXIT_FAILURE;
+    }
+    ::shutdown(fd, SHUT_WR);
+    const std::string response = serve::read_all(fd);
+    ::close(fd);
+    if (response.empty()) {
+        std::cerr << "error: empty response from server" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << response.substr(1);
+    return response.front() == serve::STATUS_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+#endif
+}
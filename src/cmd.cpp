@@ -7,7 +7,25 @@ namespace cmd {
                 << "  -f, --file <filepath>   Specify input source filepath to run\n"
                 << "  -h, --help              Show this help message and exit\n"
                 << "  -d, --debug             Enable debug mode\n"
-                << "  -r, --repl              Run in interactive REPL node" << std::endl;
+                << "  -r, --repl              Run in interactive REPL node\n"
+                << "  -s, --serve <socket>    Serve evaluation requests on a Unix domain socket,\n"
+                << "                          with --file loaded once as the prelude\n"
+                << "  --snapshot <filepath>   Write a heap snapshot image after running --file\n"
+                << "  --image <filepath>      Restore a heap snapshot image before running --file or --repl,\n"
+                << "                          starts the REPL when neither is given\n"
+                << "  --no-cache              Do not read or write the module cache for `use`d files\n"
+                << "  --fuse                  Fuse (map f xs) arguments into the builtin consuming them,\n"
+                << "                          applying f element by element along with the consumer\n"
+                << "  --profile <filepath>    Profile running --file, write collapsed stacks to <filepath>\n"
+                << "                          and print the hottest sites to stderr\n"
+                << "  --stats                 Print interpreter operation counters to stderr at exit\n"
+                << "  --stats-json <filepath> Write interpreter operation counters as JSON at exit\n"
+                << "  --trace <filepath>      Write a Chrome/Perfetto trace of lexing, parsing, `use` loads\n"
+                << "                          and evaluation after running --file\n"
+                << "  --heap-profile <filepath>\n"
+                << "                          Track live thunks, environments and lists by creating site,\n"
+                << "                          write them to <filepath> at exit and print the largest to stderr"
+                << std::endl;
     }
 
     Options parse_args(const int argc, char **argv, const std::string &program_name) {
@@ -23,6 +41,60 @@ namespace cmd {
                     print_help(std::cerr, program_name);
                     std::exit(EXIT_FAILURE);
                 }
+            } else if (arg == "-s" || arg == "--serve") {
+                if (i + 1 < argc) {
+                    opts.serve_socket = argv[++i];
+                } else {
+                    std::cerr << "error: missing socket path after " << arg << std::endl;
+                    print_help(std::cerr, program_name);
+                    std::exit(EXIT_FAILURE);
+                }
+            } else if (arg == "--snapshot" || arg == "--image") {
+                if (i + 1 < argc) {
+                    (arg == "--snapshot" ? opts.snapshot_path : opts.image_path) = argv[++i];
+                } else {
+                    std::cerr << "error: missing filepath after " << arg << std::endl;
+                    print_help(std::cerr, program_name);
+                    std::exit(EXIT_FAILURE);
+                }
+            } else if (arg == "--profile") {
+                if (i + 1 < argc) {
+                    opts.profile_path = argv[++i];
+                } else {
+                    std::cerr << "error: missing filepath after " << arg << std::endl;
+                    print_help(std::cerr, program_name);
+                    std::exit(EXIT_FAILURE);
+                }
+            } else if (arg == "--stats-json") {
+                if (i + 1 < argc) {
+                    opts.stats_json_path = argv[++i];
+                } else {
+                    std::cerr << "error: missing filepath after " << arg << std::endl;
+                    print_help(std::cerr, program_name);
+                    std::exit(EXIT_FAILURE);
+                }
+            } else if (arg == "--trace") {
+                if (i + 1 < argc) {
+                    opts.trace_path = argv[++i];
+                } else {
+                    std::cerr << "error: missing filepath after " << arg << std::endl;
+                    print_help(std::cerr, program_name);
+                    std::exit(EXIT_FAILURE);
+                }
+            } else if (arg == "--heap-profile") {
+                if (i + 1 < argc) {
+                    opts.heap_profile_path = argv[++i];
+                } else {
+                    std::cerr << "error: missing filepath after " << arg << std::endl;
+                    print_help(std::cerr, program_name);
+                    std::exit(EXIT_FAILURE);
+                }
+            } else if (arg == "--stats") {
+                opts.stats = true;
+            } else if (arg == "--no-cache") {
+                opts.no_cache = true;
+            } else if (arg == "--fuse") {
+                opts.fuse = true;
             } else if (arg == "-d" || arg == "--debug") {
                 opts.debug = true;
             } else if (arg == "-r" || arg == "--repl") {
@@ -33,6 +105,16 @@ namespace cmd {
                 std::exit(EXIT_FAILURE);
             }
         }
-        return opts;
+        if (opts.show_help || opts.serve_socket || opts.repl || opts.filepath) {
+            return opts;
+        }
+        // A restored image with nothing to run is explored in the REPL
+        if (opts.image_path) {
+            opts.repl = true;
+            return opts;
+        }
+        std::cerr << "error: nothing to run, pass --file <filepath> or --repl" << std::endl;
+        print_help(std::cerr, program_name);
+        std::exit(EXIT_FAILURE);
     }
 }
@@ -0,0 +1,107 @@
+#include <lbd/embed/module.h>
+#include <lbd/fe/lexer.h>
+#include <lbd/fe/parser.h>
+
+namespace embed {
+    options::Options default_options() {
+        return {.own_expr = false, .force_on_env_dump = false, .debug = false, .logger = logs::Logger(false, false, true)};
+    }
+
+    intp::interp::Value to_value(const double value) {
+        return intp::interp::Value{value};
+    }
+
+    intp::interp::Value to_value(const std::string_view value) {
+        return intp::interp::Value{std::string(value)};
+    }
+
+    intp::interp::Value to_value(std::string &&value) {
+        return intp::interp::Value{std::move(value)};
+    }
+
+    intp::interp::Value to_value(const std::span<const double> values) {
+        // Copied straight into the unboxed representation, never boxed
+        std::vector<double> floats(values.begin(), values.end());
+        return intp::interp::Value{std::make_shared<intp::interp::List>(intp::interp::List{std::move(floats)})};
+    }
+
+    intp::interp::Value to_value(intp::interp::Value value) {
+        return value;
+    }
+
+    intp::interp::Value Function::apply(std::vector<intp::interp::Value> args) const {
+        std::vector<std::shared_ptr<intp::interp::Thunk> > arg_thunks;
+        arg_thunks.reserve(args.size());
+        for (auto &arg: args) {
+            const auto thunk = std::make_shared<intp::interp::Thunk>();
+            thunk->cached = std::move(arg);
+            arg_thunks.push_back(thunk);
+        }
+        return intp::interp::apply_fn_apl(callee, arg_thunks, env);
+    }
+
+    Module::Module(options::Options options_) : options_v(std::move(options_)) {
+        // Interpreting an empty Program installs the builtins under this Module's options
+        fe::ast::Program empty;
+        env = intp::interp::interpret(empty, std::nullopt, options_v).global_env;
+    }
+
+    void Module::register_native(intp::interp::NativeFunction native_fn) {
+        const auto thunk = std::make_shared<intp::interp::Thunk>();
+        const std::string name = native_fn.name;
+        thunk->cached = intp::interp::Value{std::make_shared<intp::interp::NativeFunction>(std::move(native_fn))};
+        env->bind(name, thunk);
+    }
+
+    intp::interp::Value Module::load_file(const std::string &filepath) {
+        std::swap(fe::parser::loaded_files(), loaded_files);
+        try {
+            fe::lexer::Lexer lexer_v(filepath, fe::lexer::FromFile{}, options_v);
+            fe::parser::Parser parser_v(lexer_v, options_v);
+            std::swap(fe::parser::loaded_files(), loaded_files);
+            return load(std::make_unique<fe::ast::Program>(std::move(parser_v.program)));
+        } catch (...) {
+            std::swap(fe::parser::loaded_files(), loaded_files);
+            throw;
+        }
+    }
+
+    intp::interp::Value Module::load_source(std::string source) {
+        std::swap(fe::parser::loaded_files(), loaded_files);
+        try {
+            fe::lexer::Lexer lexer_v(std::move(source), fe::lexer::FromRepl{}, options_v);
+            fe::parser::Parser parser_v(lexer_v, options_v);
+            std::swap(fe::parser::loaded_files(), loaded_files);
+            return load(std::make_unique<fe::ast::Program>(std::move(parser_v.program)));
+        } catch (...) {
+            std::swap(fe::parser::loaded_files(), loaded_files);
+            throw;
+        }
+    }
+
+    intp::interp::Value Module::load(std::unique_ptr<fe::ast::Program> program) {
+        // Keep the Program alive before interpreting, Thunks bound by it point into its AST
+        programs.push_back(std::move(program));
+        return intp::interp::interpret(*programs.back(), env, options_v).value;
+    }
+
+    std::shared_ptr<intp::interp::Thunk> Module::lookup(const std::string &name) const {
+        return env->lookup(name);
+    }
+
+    const intp::interp::Value &Module::get(const std::string &name) const {
+        const auto thunk = lookup(name);
+        if (!thunk) {
+            options_v.logger.error({}, "runtime error: undefined identifier ", name);
+        }
+        return thunk->force();
+    }
+
+    Function Module::function(const std::string &name) const {
+        return Function{get(name), env};
+    }
+
+    const std::shared_ptr<intp::interp::Env> &Module::global_env() const {
+        return env;
+    }
+}
@@ -22,31 +22,22 @@ namespace fe::ast {
         return os << node.value;
     }
 
-    void LambdaExpression::print(std::ostream &os, const size_t indent) const {
+    void LambdaExpression::print(std::ostream &os, const Arena &arena, const size_t indent) const {
         print_indent(os, indent);
         os << "\\" << arg << ": " << arg_type << "." << std::endl;
-        expr->print(os, indent + 1);
+        arena[expr].print(os, arena, indent + 1);
     }
 
-    std::ostream &operator<<(std::ostream &os, const LambdaExpression &l_expr) {
-        l_expr.print(os, 0);
-        return os;
-    }
-
-    void FunctionApplication::print(std::ostream &os, const size_t indent) const {
+    void FunctionApplication::print(std::ostream &os, const Arena &arena, const size_t indent) const {
         print_indent(os, indent);
         os << "(" << fn_name;
-        for (auto &arg: args) {
-            os << " " << *arg;
+        for (const ExprId arg: arena.args_of(*this)) {
+            os << " ";
+            arena[arg].print(os, arena, 0);
         }
         os << ")";
     }
 
-    std::ostream &operator<<(std::ostream &os, const FunctionApplication &fn_apl) {
-        fn_apl.print(os, 0);
-        return os;
-    }
-
     Expression::Expression(IdenAstNode value) : value(std::move(value)) {
     }
 
@@ -62,7 +53,7 @@ namespace fe::ast {
     Expression::Expression(FunctionApplication value) : value(std::move(value)) {
     }
 
-    void Expression::print(std::ostream &os, size_t indent) const {
+    void Expression::print(std::ostream &os, const Arena &arena, size_t indent) const {
         std::visit([&]<typename T0>(T0 &&arg) {
             using T = std::decay_t<T0>;
             if constexpr (std::is_same_v<T, IdenAstNode>
@@ -71,49 +62,79 @@ namespace fe::ast {
                 print_indent(os, indent);
                 os << arg;
             } else if constexpr (std::is_same_v<T, LambdaExpression> || std::is_same_v<T, FunctionApplication>) {
-                arg.print(os, indent);
+                arg.print(os, arena, indent);
             } else {
                 STATIC_ASSERT_UNREACHABLE_T(T, "unhandled expression");
             }
         }, value);
     }
 
-    std::ostream &operator<<(std::ostream &os, const Expression &expr) {
-        expr.print(os, 0);
-        return os;
-    }
-
     loc::Loc Expression::get_loc() const {
         return std::visit([&](auto &&arg) {
             return arg.loc;
         }, value);
     }
 
-    void DefAstNode::print(std::ostream &os, size_t indent) const {
-        print_indent(os, indent);
-        os << "def " << def_name << ": " << typ << " = " << expr;
+    ExprId Arena::add(Expression expr) {
+        exprs.push_back(std::move(expr));
+        return static_cast<ExprId>(exprs.size() - 1);
     }
 
-    std::ostream &operator<<(std::ostream &os, const DefAstNode &node) {
-        node.print(os, 0);
-        return os;
+    ExprId Arena::append(Arena &&other) {
+        if (exprs.empty() && args.empty()) {
+            *this = std::move(other);
+            return 0;
+        }
+        const auto offset = static_cast<ExprId>(exprs.size());
+        const auto args_offset = static_cast<uint32_t>(args.size());
+        // Grow geometrically, an exact reserve per spliced file makes loading many files quadratic
+        if (exprs.capacity() < exprs.size() + other.exprs.size()) {
+            exprs.reserve(std::max(exprs.size() + other.exprs.size(), 2 * exprs.capacity()));
+        }
+        for (auto &expr: other.exprs) {
+            if (auto *l_expr = std::get_if<LambdaExpression>(&expr.value)) {
+                l_expr->expr += offset;
+            } else if (auto *fn_apl = std::get_if<FunctionApplication>(&expr.value)) {
+                fn_apl->args_begin += args_offset;
+            }
+            exprs.push_back(std::move(expr));
+        }
+        if (args.capacity() < args.size() + other.args.size()) {
+            args.reserve(std::max(args.size() + other.args.size(), 2 * args.capacity()));
+        }
+        for (const ExprId arg: other.args) {
+            args.push_back(arg + offset);
+        }
+        other = {};
+        return offset;
     }
 
-    void AstNode::print(std::ostream &os, size_t indent) const {
-        std::visit([&](auto &&arg) {
-            arg.print(os, indent);
-        }, value);
+    void DefAstNode::print(std::ostream &os, const Arena &arena, size_t indent) const {
+        print_indent(os, indent);
+        os << "def " << def_name << ": " << typ << " = ";
+        arena[expr].print(os, arena, 0);
+    }
+
+    void AstNode::print(std::ostream &os, const Arena &arena, size_t indent) const {
+        if (const auto *expr = std::get_if<ExprId>(&value)) {
+            arena[*expr].print(os, arena, indent);
+        } else {
+            std::get<DefAstNode>(value).print(os, arena, indent);
+        }
         os << std::endl;
     }
 
-    std::ostream &operator<<(std::ostream &os, const AstNode &node) {
-        node.print(os, 0);
-        return os;
+    void AstNode::rebase(const ExprId offset) {
+        if (auto *expr = std::get_if<ExprId>(&value)) {
+            *expr += offset;
+        } else {
+            std::get<DefAstNode>(value).expr += offset;
+        }
     }
 
     std::ostream &operator<<(std::ostream &os, const Program &p) {
         for (const ast::AstNode &node: p.nodes) {
-            os << node;
+            node.print(os, *p.arena, 0);
         }
         return os;
     }
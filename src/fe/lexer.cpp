@@ -1,11 +1,12 @@
+#include <charconv>
+#include <chrono>
 #include <lbd/fe/lexer.h>
+#include <lbd/fe/trace.h>
 #include <lbd/logs.h>
-#include <sstream>
 #include <utility>
-#include <fstream>
 
 namespace fe::lexer {
-    static options::Options options_v;
+    static thread_local options::Options options_v; /// Per-thread, used files are lexed concurrently
 
     char Lexer::peek() const {
         return pos < source.size() ? source[pos] : '\0';
@@ -16,10 +17,7 @@ namespace fe::lexer {
         if (c != '\0') {
             ++pos;
             if (c == '\n') {
-                ++row;
-                col = 1;
-            } else {
-                ++col;
+                file->line_starts.push_back(static_cast<uint32_t>(pos));
             }
         }
         return c;
@@ -30,22 +28,38 @@ namespace fe::lexer {
     }
 
     loc::Loc Lexer::get_cur_loc() const {
-        return {row, col, filepath};
+        return {file_id, static_cast<uint32_t>(pos)};
     }
 
-    Lexer::Lexer(const std::string &filepath, FromFile, options::Options options_) : filepath(filepath) {
-        std::ifstream ifs(filepath);
+    void Lexer::init(std::string filepath) {
+        // Locations store 32-bit offsets
+        if (source.size() > UINT32_MAX) {
+            options_v.logger.error({}, "IO error: source file ", filepath, " exceeds 4 GiB");
+        }
+        file_id = loc::register_file(std::move(filepath));
+        file = &loc::get_file(file_id);
+    }
+
+    Lexer::Lexer(const std::string &filepath, FromFile, options::Options options_) : mapped(
+        std::make_unique<MappedFile>(filepath)) {
         options_v = options_;
-        if (!ifs) {
-            options_v.logger.error({}, "IO error: could not open file ", filepath);
+        if (mapped->error) {
+            options_v.logger.error({}, "IO error: ", mapped->error, " ", filepath);
         }
-        std::ostringstream ss;
-        ss << ifs.rdbuf();
-        source = ss.str();
+        source = mapped->view();
+        init(filepath);
     }
 
-    Lexer::Lexer(std::string str, FromRepl, const options::Options options_) : source(std::move(str)) {
+    Lexer::Lexer(std::string str, FromRepl, const options::Options options_) : owned(std::move(str)) {
         options_v = options_;
+        source = owned;
+        init("");
+    }
+
+    Lexer::Lexer(const std::string_view source, std::string filepath, FromSource, const options::Options options_) :
+        source(source) {
+        options_v = options_;
+        init(std::move(filepath));
     }
 
     token::Token Lexer::next_token() {
@@ -59,15 +73,14 @@ namespace fe::lexer {
         if (is_eof()) {
             return {token::Eof(), cur_loc};
         }
-        // Identifiers [a-zA-Z_][a-zA-Z0-9_]*
+        // Identifiers [a-zA-Z_][a-zA-Z0-9_']*
         if (std::isalpha(c) || c == '_') {
             const size_t start = pos;
-            while (std::isalnum(c) || c == '_') {
+            while (std::isalnum(c) || c == '_' || c == '\'') {
                 get();
                 c = peek();
             }
-            const std::string value = source.substr(start, pos - start);
-            return {token::Iden{value}, cur_loc};
+            return {token::Iden{source.substr(start, pos - start)}, cur_loc};
         }
         auto lex_float = [this, &c]() -> double {
             const size_t start = pos;
@@ -83,7 +96,8 @@ namespace fe::lexer {
                     c = peek();
                 }
             }
-            const double value = std::stod(source.substr(start, pos - start));
+            double value = 0;
+            std::from_chars(source.data() + start, source.data() + pos, value);
             return value;
         };
         // Positive Float
@@ -99,7 +113,7 @@ namespace fe::lexer {
                 get();
                 c = peek();
             }
-            const std::string value = source.substr(start, pos - start);
+            const std::string_view value = source.substr(start, pos - start);
             if (c != '"') {
                 options_v.logger.error(cur_loc, "syntax error: unbalanced quote");
             }
@@ -163,4 +177,31 @@ namespace fe::lexer {
         }
         return tokens;
     }
+
+    TokenStream::TokenStream(Lexer &lexer_v) : lexer_v(lexer_v), cur(lexer_v.next_token()), debug(options_v.debug) {
+        if (debug) {
+            options_v.logger.debug(cur);
+        }
+    }
+
+    const token::Token &TokenStream::peek() const {
+        return cur;
+    }
+
+    void TokenStream::advance() {
+        // Eof is sticky, the parser may peek past the end while reporting errors
+        if (!std::holds_alternative<token::Eof>(cur.typ)) {
+            if (trace::enabled) {
+                const auto start = std::chrono::steady_clock::now();
+                cur = lexer_v.next_token();
+                lex_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+            } else {
+                cur = lexer_v.next_token();
+            }
+            if (debug) {
+                options_v.logger.debug(cur);
+            }
+        }
+    }
 }
@@ -1,13 +1,90 @@
+#include <algorithm>
+#include <deque>
+#include <mutex>
 #include <lbd/fe/loc.h>
 
-#include <utility>
-
 namespace fe::loc {
-    Loc::Loc(const size_t row, const size_t col, std::string filepath) : row(row), col(col),
-                                                                         filepath(std::move(filepath)) {
+    static std::mutex files_mutex;
+    static std::deque<SourceFile> files{SourceFile{}}; // Deque keeps references stable on growth
+    static std::vector<uint32_t> released_ids;
+    static EphemeralFiles *ephemeral_scope = nullptr;
+
+    size_t SourceFile::row(const uint32_t offset) const {
+        return static_cast<size_t>(std::upper_bound(line_starts.begin(), line_starts.end(), offset) -
+                                   line_starts.begin());
+    }
+
+    size_t SourceFile::col(const uint32_t offset) const {
+        return offset - line_starts[row(offset) - 1] + 1;
+    }
+
+    uint32_t register_file(std::string filepath) {
+        std::lock_guard lock(files_mutex);
+        uint32_t file_id;
+        if (!released_ids.empty()) {
+            file_id = released_ids.back();
+            released_ids.pop_back();
+            files[file_id] = SourceFile{std::move(filepath)};
+        } else {
+            files.push_back(SourceFile{std::move(filepath)});
+            file_id = static_cast<uint32_t>(files.size() - 1);
+        }
+        if (ephemeral_scope) {
+            ephemeral_scope->file_ids.push_back(file_id);
+        }
+        return file_id;
+    }
+
+    SourceFile &get_file(const uint32_t file_id) {
+        std::lock_guard lock(files_mutex);
+        return files[file_id < files.size() ? file_id : 0];
+    }
+
+    EphemeralFiles::EphemeralFiles() {
+        std::lock_guard lock(files_mutex);
+        outer = ephemeral_scope;
+        ephemeral_scope = this;
+    }
+
+    EphemeralFiles::~EphemeralFiles() {
+        std::lock_guard lock(files_mutex);
+        ephemeral_scope = outer;
+        if (kept) {
+            return;
+        }
+        // Nested scopes hand their files to the outermost one, Locs may still be printed until it ends
+        if (outer) {
+            outer->file_ids.insert(outer->file_ids.end(), file_ids.begin(), file_ids.end());
+            return;
+        }
+        for (const uint32_t file_id: file_ids) {
+            // Drop the line table now rather than when the entry is reused
+            files[file_id] = SourceFile{};
+            released_ids.push_back(file_id);
+        }
+    }
+
+    void EphemeralFiles::keep() {
+        kept = true;
+    }
+
+    Loc::Loc(const uint32_t file_id, const uint32_t offset) : file_id(file_id), offset(offset) {
+    }
+
+    const std::string &Loc::filepath() const {
+        return get_file(file_id).filepath;
+    }
+
+    size_t Loc::row() const {
+        return get_file(file_id).row(offset);
+    }
+
+    size_t Loc::col() const {
+        return get_file(file_id).col(offset);
     }
 
     std::ostream &operator<<(std::ostream &os, const Loc &loc) {
-        return os << loc.filepath << ":" << loc.row << ":" << loc.col;
+        const SourceFile &file = get_file(loc.file_id);
+        return os << file.filepath << ":" << file.row(loc.offset) << ":" << file.col(loc.offset);
     }
 }
@@ -0,0 +1,186 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <lbd/fe/module_cache.h>
+#include <lbd/fe/serialize.h>
+
+namespace fe::module_cache {
+    static constexpr char MAGIC[4] = {'L', 'B', 'D', 'C'};
+
+    enum class ItemTag : uint8_t { Node, Use };
+
+    uint64_t hash(const std::string_view data) {
+        uint64_t h = 14695981039346656037ull;
+        for (const char c: data) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    std::filesystem::path cache_dir() {
+        if (const char *dir = std::getenv("LBD_CACHE_DIR"); dir && *dir) {
+            return dir;
+        }
+#if defined(_WIN32)
+        if (const char *dir = std::getenv("LOCALAPPDATA"); dir && *dir) {
+            return std::filesystem::path(dir) / "lbd";
+        }
+#else
+        // Relative values are invalid per the XDG base directory spec and ignored
+        if (const char *dir = std::getenv("XDG_CACHE_HOME"); dir && *dir == '/') {
+            return std::filesystem::path(dir) / "lbd";
+        }
+        if (const char *home = std::getenv("HOME"); home && *home == '/') {
+            return std::filesystem::path(home) / ".cache" / "lbd";
+        }
+#endif
+        return {};
+    }
+
+    /// Whether path is a directory not writable by others, or a regular file, owned by the current user.
+    /// Symlinks are refused, so another user cannot redirect the cache to a location they control.
+    static bool owned_by_user(const std::filesystem::path &path, const bool directory) {
+#if defined(_WIN32)
+        std::error_code ec;
+        return directory ? std::filesystem::is_directory(path, ec) : std::filesystem::is_regular_file(path, ec);
+#else
+        struct stat st{};
+        if (::lstat(path.c_str(), &st) != 0 || st.st_uid != ::geteuid()) {
+            return false;
+        }
+        return directory ? S_ISDIR(st.st_mode) && !(st.st_mode & (S_IWGRP | S_IWOTH)) : S_ISREG(st.st_mode);
+#endif
+    }
+
+    /// Creates the cache directory private to the current user if missing, false when it cannot be used
+    static bool prepare_cache_dir(const std::filesystem::path &dir) {
+        if (dir.empty()) {
+            return false;
+        }
+        std::error_code ec;
+        if (dir.has_parent_path()) {
+            std::filesystem::create_directories(dir.parent_path(), ec);
+        }
+#if defined(_WIN32)
+        std::filesystem::create_directory(dir, ec);
+#else
+        // An existing directory is kept as is and vetted below
+        ::mkdir(dir.c_str(), 0700);
+#endif
+        return owned_by_user(dir, true);
+    }
+
+    static std::filesystem::path entry_path(const std::filesystem::path &dir, const std::string &abs_path) {
+        std::ostringstream name;
+        name << std::hex << hash(abs_path) << ".lbdc";
+        return dir / name.str();
+    }
+
+    std::optional<ast::Unit> load(const std::string &abs_path, const uint64_t content_hash,
+                                  const options::Options &options_) {
+        const auto dir = cache_dir();
+        if (!prepare_cache_dir(dir)) {
+            return std::nullopt;
+        }
+        const auto path = entry_path(dir, abs_path);
+        if (!owned_by_user(path, false)) {
+            return std::nullopt;
+        }
+        std::ifstream ifs(path, std::ios::in | std::ios::binary);
+        if (!ifs) {
+            return std::nullopt;
+        }
+        const std::string data((std::istreambuf_iterator(ifs)), std::istreambuf_iterator<char>());
+        if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+            return std::nullopt;
+        }
+        // A corrupt entry is reported and treated as a miss instead of aborting the load
+        options::Options reader_options = options_;
+        reader_options.logger.exit_on_error = false;
+        reader_options.logger.capture = nullptr;
+        serialize::Reader r(data.data(), data.size(), reader_options);
+        r.pos = sizeof(MAGIC);
+        ast::Unit unit;
+        try {
+            // Stale entries are rejected by the header
+            if (r.u32() != serialize::FORMAT_VERSION || r.str() != serialize::build_id() || r.str() != abs_path ||
+                r.u64() != content_hash) {
+                return std::nullopt;
+            }
+            unit.arena = serialize::read_arena(r);
+            const uint32_t n = r.u32();
+            unit.items.reserve(n);
+            for (uint32_t i = 0; i < n; ++i) {
+                if (static_cast<ItemTag>(r.u8()) == ItemTag::Node) {
+                    unit.items.emplace_back(serialize::read_ast_node(r, unit.arena));
+                } else {
+                    std::string filepath = r.str();
+                    unit.items.emplace_back(ast::UseDirective{std::move(filepath), serialize::read_loc(r)});
+                }
+            }
+        } catch (const ControlledExit &) {
+            return std::nullopt;
+        }
+        if (options_.debug) {
+            options_.logger.debug("debug: module cache hit ", abs_path);
+        }
+        return unit;
+    }
+
+    void store(const std::string &abs_path, const uint64_t content_hash, const ast::Unit &unit,
+               const options::Options &options_) {
+        serialize::Writer w;
+        w.buffer.append(MAGIC, sizeof(MAGIC));
+        w.u32(serialize::FORMAT_VERSION);
+        w.str(serialize::build_id());
+        w.str(abs_path);
+        w.u64(content_hash);
+        serialize::write_arena(w, unit.arena);
+        w.u32(static_cast<uint32_t>(unit.items.size()));
+        for (const auto &item: unit.items) {
+            if (const auto *node = std::get_if<ast::AstNode>(&item)) {
+                w.u8(static_cast<uint8_t>(ItemTag::Node));
+                serialize::write_ast_node(w, *node);
+            } else {
+                const auto &[filepath, loc] = std::get<ast::UseDirective>(item);
+                w.u8(static_cast<uint8_t>(ItemTag::Use));
+                w.str(filepath);
+                serialize::write_loc(w, loc);
+            }
+        }
+
+        const auto dir = cache_dir();
+        if (!prepare_cache_dir(dir)) {
+            return;
+        }
+        std::error_code ec;
+        const auto path = entry_path(dir, abs_path);
+        // Write then rename, so concurrent readers never observe a partial entry
+        auto tmp_path = path;
+        tmp_path += "." + std::to_string(hash(w.buffer)) + ".tmp";
+        {
+            std::ofstream ofs(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!ofs) {
+                return;
+            }
+            ofs.write(w.buffer.data(), static_cast<std::streamsize>(w.buffer.size()));
+            if (!ofs) {
+                ofs.close();
+                std::filesystem::remove(tmp_path, ec);
+                return;
+            }
+        }
+        std::filesystem::rename(tmp_path, path, ec);
+        if (ec) {
+            std::filesystem::remove(tmp_path, ec);
+        } else if (options_.debug) {
+            options_.logger.debug("debug: module cache stored ", abs_path);
+        }
+    }
+}
@@ -1,47 +1,96 @@
 #include <lbd/fe/loc.h>
 #include <lbd/fe/lexer.h>
 #include <lbd/fe/parser.h>
+#include <lbd/fe/module_cache.h>
+#include <lbd/fe/trace.h>
 #include <lbd/utils/string_escape.h>
+#include <atomic>
+#include <unordered_map>
 #include <unordered_set>
 #include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 namespace fe::parser {
-    static std::unordered_set<std::string> loaded_files;
-    static options::Options options_v;
+    static std::unordered_set<std::string> loaded_files_v;
+    static std::mutex loaded_files_mutex;
+    static thread_local options::Options options_v; /// Per-thread, used files are parsed concurrently
+    /// Units of used files loaded ahead of splicing, keyed by absolute filepath
+    static std::unordered_map<std::string, ast::Unit> preloaded_units;
 
-    Parser::Parser(const std::vector<token::Token> &tokens, const options::Options options_) {
+    std::unordered_set<std::string> &loaded_files() {
+        return loaded_files_v;
+    }
+
+    /// Returns false when the file was already loaded (Circular Dependency or Duplicate Load)
+    static bool claim_file(const std::string &abs_path) {
+        std::lock_guard lock(loaded_files_mutex);
+        return loaded_files_v.insert(abs_path).second;
+    }
+
+    static bool is_file_loaded(const std::string &abs_path) {
+        std::lock_guard lock(loaded_files_mutex);
+        return loaded_files_v.contains(abs_path);
+    }
+
+    static void splice_unit(ast::Program &program, ast::Unit unit);
+
+    static void preload_units(const ast::Unit &unit);
+
+    /// Drops the preloaded units however parsing ends, a REPL parse error must not leak them into the next input
+    struct PreloadedUnitsScope {
+        PreloadedUnitsScope() = default;
+
+        ~PreloadedUnitsScope() {
+            preloaded_units.clear();
+        }
+
+        PreloadedUnitsScope(const PreloadedUnitsScope &) = delete;
+
+        PreloadedUnitsScope &operator=(const PreloadedUnitsScope &) = delete;
+    };
+
+    Parser::Parser(lexer::Lexer &lexer_v, const options::Options options_) {
         options_v = options_;
-        size_t i = 0;
-        program = ast::Program{build_ast(tokens, i)};
+        trace::Span span("parse");
+        lexer::TokenStream tokens(lexer_v);
+        auto unit = build_unit(tokens);
+        if (span) {
+            span.name = "parse " + tokens.peek().loc.filepath();
+            span.args = "\"lex_ms\": " + std::to_string(static_cast<double>(tokens.lex_ns) / 1e6);
+        }
+        const PreloadedUnitsScope preloaded_scope;
+        preload_units(unit);
+        splice_unit(program, std::move(unit));
     }
 
     template<typename T>
-    void Parser::assert_token(const std::vector<token::Token> &tokens, size_t &i) {
-        if (const token::Token &cur_token = tokens[i]; !std::holds_alternative<T>(cur_token.typ)) {
+    void Parser::assert_token(lexer::TokenStream &tokens) {
+        if (const token::Token &cur_token = tokens.peek(); !std::holds_alternative<T>(cur_token.typ)) {
             options_v.logger.error(cur_token.loc, "syntax error: expected ", token::to_string<T>(), ", got ",
                                    cur_token.to_string());
         }
     }
 
     template<typename T>
-    void Parser::assert_n_eat(const std::vector<token::Token> &tokens, size_t &i) {
-        assert_token<T>(tokens, i);
-        ++i;
+    void Parser::assert_n_eat(lexer::TokenStream &tokens) {
+        assert_token<T>(tokens);
+        tokens.advance();
     }
 
-    ast::IdenAstNode Parser::eat_iden(const std::vector<token::Token> &tokens, size_t &i) {
-        assert_token<token::Iden>(tokens, i);
-        auto [value] = std::get<token::Iden>(tokens[i].typ);
-        const loc::Loc loc = tokens[i].loc;
-        ++i;
-        return ast::IdenAstNode{value, loc};
+    ast::IdenAstNode Parser::eat_iden(lexer::TokenStream &tokens) {
+        assert_token<token::Iden>(tokens);
+        auto [value] = std::get<token::Iden>(tokens.peek().typ);
+        const loc::Loc loc = tokens.peek().loc;
+        tokens.advance();
+        return ast::IdenAstNode{std::string(value), loc};
     }
 
-    intp::types::PrimitiveType Parser::eat_primitive_type_name(const std::vector<token::Token> &tokens, size_t &i) {
-        assert_token<token::Iden>(tokens, i);
-        auto [value] = std::get<token::Iden>(tokens[i].typ);
-        loc::Loc loc = tokens[i].loc;
-        ++i;
+    intp::types::PrimitiveType Parser::eat_primitive_type_name(lexer::TokenStream &tokens) {
+        assert_token<token::Iden>(tokens);
+        auto [value] = std::get<token::Iden>(tokens.peek().typ);
+        tokens.advance();
         if (value == "Float") {
             return intp::types::PrimitiveType{intp::types::PrimitiveType::Type::Float};
         }
@@ -51,15 +100,15 @@ namespace fe::parser {
         if (value == "Any") {
             return intp::types::PrimitiveType{intp::types::PrimitiveType::Type::Any};
         }
-        return intp::types::PrimitiveType{intp::types::PrimitiveType::Type::Custom, std::move(value)};
+        return intp::types::PrimitiveType{intp::types::PrimitiveType::Type::Custom, std::string(value)};
     }
 
-    intp::types::Type Parser::parse_type(const std::vector<token::Token> &tokens, size_t &i) {
-        intp::types::PrimitiveType typ = eat_primitive_type_name(tokens, i);
+    intp::types::Type Parser::parse_type(lexer::TokenStream &tokens) {
+        intp::types::PrimitiveType typ = eat_primitive_type_name(tokens);
         std::vector types{typ};
-        while (std::holds_alternative<token::Arrow>(tokens[i].typ)) {
-            assert_n_eat<token::Arrow>(tokens, i);
-            types.push_back(eat_primitive_type_name(tokens, i));
+        while (std::holds_alternative<token::Arrow>(tokens.peek().typ)) {
+            assert_n_eat<token::Arrow>(tokens);
+            types.push_back(eat_primitive_type_name(tokens));
         }
         if (types.size() == 1) {
             return typ;
@@ -75,118 +124,234 @@ namespace fe::parser {
         return c_typ;
     }
 
-    ast::Expression Parser::parse_expression(const std::vector<token::Token> &tokens, size_t &i) {
-        const auto &tok = tokens[i];
+    ast::ExprId Parser::parse_expression(lexer::TokenStream &tokens, ast::Arena &arena) {
+        const token::Token tok = tokens.peek(); // Copied, advancing replaces the current token
         const loc::Loc loc = tok.loc;
         return std::visit([&]<typename T0>(T0 &&) {
             using T = std::decay_t<T0>;
             if (std::is_same_v<T, token::Iden>) {
-                ++i;
+                tokens.advance();
                 const auto value = std::get<token::Iden>(tok.typ).value;
-                return ast::Expression(ast::IdenAstNode{value, loc});
+                return arena.add(ast::Expression(ast::IdenAstNode{std::string(value), loc}));
             }
             if (std::is_same_v<T, token::String>) {
-                ++i;
+                tokens.advance();
                 const auto value = unescape_string(std::get<token::String>(tok.typ).value);
-                return ast::Expression(ast::StringAstNode{value, loc});
+                return arena.add(ast::Expression(ast::StringAstNode{value, loc}));
             }
             if (std::is_same_v<T, token::Float>) {
-                ++i;
+                tokens.advance();
                 const auto value = std::get<token::Float>(tok.typ).value;
-                return ast::Expression(ast::FloatAstNode{value, loc});
+                return arena.add(ast::Expression(ast::FloatAstNode{value, loc}));
             }
             if (std::is_same_v<T, token::BackwardSlash>) {
-                return ast::Expression(parse_lambda_expression(tokens, i));
+                return arena.add(ast::Expression(parse_lambda_expression(tokens, arena)));
             }
             if (std::is_same_v<T, token::OpenParen>) {
-                return ast::Expression(parse_function_application(tokens, i));
+                return arena.add(ast::Expression(parse_function_application(tokens, arena)));
             }
             options_v.logger.error(loc, "syntax error: unexpected token ", tok.to_string());
         }, tok.typ);
     }
 
-    ast::LambdaExpression Parser::parse_lambda_expression(const std::vector<token::Token> &tokens, size_t &i) {
-        loc::Loc loc = tokens[i].loc;
-        assert_n_eat<token::BackwardSlash>(tokens, i);
-        ast::IdenAstNode arg = eat_iden(tokens, i);
-        assert_n_eat<token::Colon>(tokens, i);
-        intp::types::Type arg_type = parse_type(tokens, i);
-        assert_n_eat<token::Dot>(tokens, i);
-        ast::Expression expr = parse_expression(tokens, i);
-        return ast::LambdaExpression{arg, arg_type, std::make_unique<ast::Expression>(std::move(expr)), loc};
+    ast::LambdaExpression Parser::parse_lambda_expression(lexer::TokenStream &tokens, ast::Arena &arena) {
+        loc::Loc loc = tokens.peek().loc;
+        assert_n_eat<token::BackwardSlash>(tokens);
+        ast::IdenAstNode arg = eat_iden(tokens);
+        assert_n_eat<token::Colon>(tokens);
+        intp::types::Type arg_type = parse_type(tokens);
+        assert_n_eat<token::Dot>(tokens);
+        const ast::ExprId expr = parse_expression(tokens, arena);
+        return ast::LambdaExpression{.arg = arg, .arg_type = arg_type, .expr = expr, .loc = loc, .lmd_expr_type = {}};
     }
 
-    ast::FunctionApplication Parser::parse_function_application(const std::vector<token::Token> &tokens, size_t &i) {
-        const loc::Loc loc = tokens[i].loc;
-        assert_n_eat<token::OpenParen>(tokens, i);
-        const ast::IdenAstNode fn_name = eat_iden(tokens, i);
-        std::vector<std::unique_ptr<ast::Expression> > args;
-        while (!std::holds_alternative<token::CloseParen>(tokens[i].typ)) {
-            args.push_back(std::make_unique<ast::Expression>(std::move(parse_expression(tokens, i))));
+    ast::FunctionApplication Parser::parse_function_application(lexer::TokenStream &tokens, ast::Arena &arena) {
+        const loc::Loc loc = tokens.peek().loc;
+        assert_n_eat<token::OpenParen>(tokens);
+        const ast::IdenAstNode fn_name = eat_iden(tokens);
+        // Nested applications append their own arguments first, so collect ours before copying them in
+        std::vector<ast::ExprId> args;
+        while (!std::holds_alternative<token::CloseParen>(tokens.peek().typ)) {
+            args.push_back(parse_expression(tokens, arena));
         }
-        assert_n_eat<token::CloseParen>(tokens, i);
-        return ast::FunctionApplication{fn_name, std::move(args), loc};
+        assert_n_eat<token::CloseParen>(tokens);
+        const auto args_begin = static_cast<uint32_t>(arena.args.size());
+        arena.args.insert(arena.args.end(), args.begin(), args.end());
+        return ast::FunctionApplication{fn_name, args_begin, static_cast<uint32_t>(args.size()), loc};
     }
 
-    ast::DefAstNode Parser::parse_def_ast_node(const std::vector<token::Token> &tokens, size_t &i) {
-        loc::Loc loc = tokens[i].loc;
-        ast::IdenAstNode def_name = eat_iden(tokens, i);
-        assert_n_eat<token::Colon>(tokens, i);
-        intp::types::Type typ = parse_type(tokens, i);
-        assert_n_eat<token::Equal>(tokens, i);
-        ast::Expression expr = parse_expression(tokens, i);
-        return ast::DefAstNode{def_name, typ, std::move(expr), loc};
+    ast::DefAstNode Parser::parse_def_ast_node(lexer::TokenStream &tokens, ast::Arena &arena) {
+        loc::Loc loc = tokens.peek().loc;
+        ast::IdenAstNode def_name = eat_iden(tokens);
+        assert_n_eat<token::Colon>(tokens);
+        intp::types::Type typ = parse_type(tokens);
+        assert_n_eat<token::Equal>(tokens);
+        const ast::ExprId expr = parse_expression(tokens, arena);
+        return ast::DefAstNode{def_name, typ, expr, loc};
     }
 
     static std::string get_abs_path(const std::string &path) {
         return std::filesystem::absolute(path).string();
     }
 
-    static void process_use_file(std::vector<ast::AstNode> &nodes, const std::string &filepath) {
+    // Lex and parse a used file into its own top-level items, going through the module cache when enabled
+    static ast::Unit load_unit(const std::string &filepath, const std::string &abs_path) {
+        trace::Span span("use");
+        if (span) {
+            span.name = "load " + filepath;
+        }
+        const MappedFile file(filepath);
+        if (file.error) {
+            options_v.logger.error({}, "IO error: ", file.error, " ", filepath);
+        }
+        const uint64_t content_hash = module_cache::hash(file.view());
+        if (options_v.module_cache) {
+            if (auto unit = module_cache::load(abs_path, content_hash, options_v)) {
+                if (span) {
+                    span.args = "\"module_cache\": \"hit\"";
+                }
+                return std::move(*unit);
+            }
+        }
+        lexer::Lexer lexer_v(file.view(), filepath, lexer::FromSource{}, options_v);
+        lexer::TokenStream tokens(lexer_v);
+        auto unit = Parser::build_unit(tokens);
+        if (span) {
+            span.args = "\"module_cache\": \"miss\", \"lex_ms\": " +
+                        std::to_string(static_cast<double>(tokens.lex_ns) / 1e6);
+        }
+        if (options_v.module_cache) {
+            module_cache::store(abs_path, content_hash, unit, options_v);
+        }
+        return unit;
+    }
+
+    static void parallel_for(const size_t n, const std::function<void(size_t)> &fn) {
+        const size_t workers = std::min<size_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+        if (workers <= 1) {
+            for (size_t k = 0; k < n; ++k) {
+                fn(k);
+            }
+            return;
+        }
+        std::atomic<size_t> next = 0;
+        std::vector<std::jthread> threads;
+        threads.reserve(workers);
+        for (size_t w = 0; w < workers; ++w) {
+            threads.emplace_back([&] {
+                for (size_t k; (k = next++) < n;) {
+                    fn(k);
+                }
+            });
+        }
+    }
+
+    // Discover every transitively used file and load them concurrently, one wave per `use` depth.
+    // Splicing afterward stays sequential and in source order, so the resulting Program is unchanged.
+    static void preload_units(const ast::Unit &root) {
+        std::unordered_set<std::string> seen;
+        std::vector<std::pair<std::string, std::string> > frontier; // (filepath, absolute filepath)
+        auto discover = [&](const ast::Unit &unit) {
+            for (const auto &item: unit.items) {
+                if (const auto *use = std::get_if<ast::UseDirective>(&item)) {
+                    std::string abs_path = get_abs_path(use->filepath);
+                    if (!is_file_loaded(abs_path) && seen.insert(abs_path).second) {
+                        frontier.emplace_back(use->filepath, std::move(abs_path));
+                    }
+                }
+            }
+        };
+        discover(root);
+        const options::Options options_ = options_v;
+        while (!frontier.empty()) {
+            const auto wave = std::move(frontier);
+            frontier.clear();
+            std::vector<ast::Unit> units(wave.size());
+            std::vector<std::exception_ptr> errors(wave.size());
+            // Workers must not print or exit while others still run, they capture their diagnostic instead
+            std::vector<std::string> diagnostics(wave.size());
+            parallel_for(wave.size(), [&](const size_t k) {
+                options_v = options_;
+                options_v.logger.capture = &diagnostics[k];
+                try {
+                    units[k] = load_unit(wave[k].first, wave[k].second);
+                } catch (...) {
+                    errors[k] = std::current_exception();
+                }
+            });
+            options_v = options_;
+            // The first failure in source order is reported, whichever worker hit it first
+            for (size_t k = 0; k < wave.size(); ++k) {
+                if (!diagnostics[k].empty()) {
+                    options_v.logger.error({}, diagnostics[k]);
+                }
+                if (errors[k]) {
+                    std::rethrow_exception(errors[k]);
+                }
+            }
+            for (size_t k = 0; k < wave.size(); ++k) {
+                discover(units[k]);
+                preloaded_units[wave[k].second] = std::move(units[k]);
+            }
+        }
+    }
+
+    static void process_use_file(ast::Program &program, const std::string &filepath) {
         const std::string abs_path = get_abs_path(filepath);
-        if (loaded_files.contains(abs_path)) {
+        if (!claim_file(abs_path)) {
             // Circular Dependency or Duplicate Load
             return;
         }
-        loaded_files.insert(abs_path);
-        auto lexer_v = lexer::Lexer(filepath, lexer::FromFile{}, options_v);
-        const auto tokens = lexer_v.lex_all();
-        if (options_v.debug) {
-            for (const auto &tok: tokens) {
-                options_v.logger.debug(tok);
-            }
+        if (const auto it = preloaded_units.find(abs_path); it != preloaded_units.end()) {
+            auto unit = std::move(it->second);
+            preloaded_units.erase(it);
+            splice_unit(program, std::move(unit));
+        } else {
+            splice_unit(program, load_unit(filepath, abs_path));
         }
-        for (Parser parser(tokens, options_v); auto &node: parser.program.nodes) {
-            nodes.emplace_back(std::move(node));
+    }
+
+    // Inline the nodes of every `use`d file in place of its directive, moving their Expressions into the Program's Arena
+    static void splice_unit(ast::Program &program, ast::Unit unit) {
+        const ast::ExprId offset = program.arena->append(std::move(unit.arena));
+        for (auto &item: unit.items) {
+            if (auto *node = std::get_if<ast::AstNode>(&item)) {
+                node->rebase(offset);
+                program.nodes.push_back(std::move(*node));
+            } else {
+                process_use_file(program, std::get<ast::UseDirective>(item).filepath);
+            }
         }
     }
 
-    std::vector<ast::AstNode> Parser::build_ast(const std::vector<token::Token> &tokens, size_t &i) {
-        std::vector<ast::AstNode> nodes;
-        while (!std::holds_alternative<token::Eof>(tokens[i].typ)) {
-            const token::Token &tok = tokens[i];
+    ast::Unit Parser::build_unit(lexer::TokenStream &tokens) {
+        ast::Unit unit;
+        auto &[arena, items] = unit;
+        while (!std::holds_alternative<token::Eof>(tokens.peek().typ)) {
+            const token::Token tok = tokens.peek();
             std::visit([&]<typename T0>(T0 &&) {
                 using T = std::decay_t<T0>;
                 if constexpr (std::is_same_v<T, token::Iden>) {
-                    if (const auto iden_value = std::get<token::Iden>(tokens[i].typ).value; iden_value == "use") {
-                        ++i; // eat "use"
-                        assert_token<token::String>(tokens, i);
-                        const std::string filepath = unescape_string(std::get<token::String>(tokens[i].typ).value);
-                        ++i; // eat <filepath>
-                        process_use_file(nodes, filepath);
+                    if (const auto iden_value = std::get<token::Iden>(tokens.peek().typ).value; iden_value == "use") {
+                        const loc::Loc loc = tokens.peek().loc;
+                        tokens.advance(); // eat "use"
+                        assert_token<token::String>(tokens);
+                        std::string filepath = unescape_string(std::get<token::String>(tokens.peek().typ).value);
+                        tokens.advance(); // eat <filepath>
+                        items.emplace_back(ast::UseDirective{std::move(filepath), loc});
                     } else {
-                        nodes.push_back(ast::AstNode{std::move(parse_def_ast_node(tokens, i))});
+                        items.emplace_back(ast::AstNode{std::move(parse_def_ast_node(tokens, arena))});
                     }
                 } else if constexpr (std::is_same_v<T, token::String> ||
                                      std::is_same_v<T, token::Float> ||
                                      std::is_same_v<T, token::BackwardSlash> ||
                                      std::is_same_v<T, token::OpenParen>) {
-                    nodes.push_back(ast::AstNode{std::move(parse_expression(tokens, i))});
+                    items.emplace_back(ast::AstNode{parse_expression(tokens, arena)});
                 } else {
                     options_v.logger.error(tok.loc, "syntax error: unexpected token ", tok.to_string());
                 }
             }, tok.typ);
         }
-        return nodes;
+        return unit;
     }
 }
@@ -0,0 +1,302 @@
+#include <cstring>
+#include <lbd/error.h>
+#include <lbd/fe/serialize.h>
+
+#ifndef LBD_BUILD_ID
+#define LBD_BUILD_ID "dev"
+#endif
+
+namespace fe::serialize {
+    std::string_view build_id() {
+        return LBD_BUILD_ID;
+    }
+
+    void Writer::u8(const uint8_t value) {
+        buffer.push_back(static_cast<char>(value));
+    }
+
+    void Writer::u32(const uint32_t value) {
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void Writer::u64(const uint64_t value) {
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void Writer::f64(const double value) {
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void Writer::str(const std::string_view value) {
+        u32(static_cast<uint32_t>(value.size()));
+        buffer.append(value.data(), value.size());
+    }
+
+    Reader::Reader(const char *data, const size_t size, options::Options options_) : data(data), size(size),
+        options_v(std::move(options_)) {
+    }
+
+    void Reader::require(const size_t n) {
+        if (size - pos < n) {
+            options_v.logger.error({}, "IO error: truncated or corrupt binary data at offset ", pos);
+        }
+    }
+
+    uint8_t Reader::u8() {
+        require(1);
+        return static_cast<uint8_t>(data[pos++]);
+    }
+
+    uint32_t Reader::u32() {
+        require(sizeof(uint32_t));
+        uint32_t value;
+        std::memcpy(&value, data + pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    }
+
+    uint64_t Reader::u64() {
+        require(sizeof(uint64_t));
+        uint64_t value;
+        std::memcpy(&value, data + pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    }
+
+    double Reader::f64() {
+        require(sizeof(double));
+        double value;
+        std::memcpy(&value, data + pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    }
+
+    std::string Reader::str() {
+        const uint32_t n = u32();
+        require(n);
+        std::string value(data + pos, n);
+        pos += n;
+        return value;
+    }
+
+    bool Reader::is_eof() const {
+        return pos >= size;
+    }
+
+    // Expression tags follow the order of ast::Expression::ExpressionVariant
+    enum class ExprTag : uint8_t { Iden, String, Float, Lambda, FnApl };
+
+    enum class TypeTag : uint8_t { Primitive, Compound };
+
+    enum class NodeTag : uint8_t { Expression, Def };
+
+    // Source files are written inline on first reference and referred to by stream-local index afterward
+    void write_loc(Writer &w, const loc::Loc &loc) {
+        const auto [it, inserted] = w.file_ids.emplace(loc.file_id, static_cast<uint32_t>(w.file_ids.size()));
+        w.u32(it->second);
+        if (inserted) {
+            const loc::SourceFile &file = loc::get_file(loc.file_id);
+            w.str(file.filepath);
+            w.u32(static_cast<uint32_t>(file.line_starts.size()));
+            for (const uint32_t line_start: file.line_starts) {
+                w.u32(line_start);
+            }
+        }
+        w.u32(loc.offset);
+    }
+
+    loc::Loc read_loc(Reader &r) {
+        const uint32_t index = r.u32();
+        if (index == r.file_ids.size()) {
+            const uint32_t file_id = loc::register_file(r.str());
+            loc::SourceFile &file = loc::get_file(file_id);
+            const uint32_t n = r.u32();
+            file.line_starts.clear();
+            file.line_starts.reserve(n);
+            for (uint32_t i = 0; i < n; ++i) {
+                file.line_starts.push_back(r.u32());
+            }
+            r.file_ids.push_back(file_id);
+        } else if (index > r.file_ids.size()) {
+            r.options_v.logger.error({}, "IO error: corrupt source file index ", index);
+        }
+        const uint32_t offset = r.u32();
+        return {r.file_ids[index], offset};
+    }
+
+    static void write_primitive_type(Writer &w, const intp::types::PrimitiveType &typ) {
+        w.u8(static_cast<uint8_t>(typ.type));
+        w.str(typ.custom);
+    }
+
+    static intp::types::PrimitiveType read_primitive_type(Reader &r) {
+        const auto type = static_cast<intp::types::PrimitiveType::Type>(r.u8());
+        return {type, r.str()};
+    }
+
+    void write_type(Writer &w, const intp::types::Type &typ) {
+        std::visit([&]<typename T0>(T0 &&arg) {
+            using T = std::decay_t<T0>;
+            if constexpr (std::is_same_v<T, intp::types::PrimitiveType>) {
+                w.u8(static_cast<uint8_t>(TypeTag::Primitive));
+                write_primitive_type(w, arg);
+            } else if constexpr (std::is_same_v<T, std::shared_ptr<intp::types::CompoundType> >) {
+                w.u8(static_cast<uint8_t>(TypeTag::Compound));
+                write_primitive_type(w, arg->l_type);
+                write_type(w, arg->r_type);
+            } else {
+                STATIC_ASSERT_UNREACHABLE_T(T, "unhandled type");
+            }
+        }, typ);
+    }
+
+    intp::types::Type read_type(Reader &r) {
+        if (static_cast<TypeTag>(r.u8()) == TypeTag::Primitive) {
+            return read_primitive_type(r);
+        }
+        auto c_typ = std::make_shared<intp::types::CompoundType>();
+        c_typ->l_type = read_primitive_type(r);
+        c_typ->r_type = read_type(r);
+        return c_typ;
+    }
+
+    static void write_iden(Writer &w, const ast::IdenAstNode &node) {
+        w.str(node.value);
+        write_loc(w, node.loc);
+    }
+
+    static ast::IdenAstNode read_iden(Reader &r) {
+        std::string value = r.str();
+        return {std::move(value), read_loc(r)};
+    }
+
+    // Children always precede their parent in an Arena, so Expressions are written flat and in order
+    static void write_expression(Writer &w, const ast::Expression &expr) {
+        std::visit([&]<typename T0>(T0 &&arg) {
+            using T = std::decay_t<T0>;
+            if constexpr (std::is_same_v<T, ast::IdenAstNode>) {
+                w.u8(static_cast<uint8_t>(ExprTag::Iden));
+                write_iden(w, arg);
+            } else if constexpr (std::is_same_v<T, ast::StringAstNode>) {
+                w.u8(static_cast<uint8_t>(ExprTag::String));
+                w.str(arg.value);
+                write_loc(w, arg.loc);
+            } else if constexpr (std::is_same_v<T, ast::FloatAstNode>) {
+                w.u8(static_cast<uint8_t>(ExprTag::Float));
+                w.f64(arg.value);
+                write_loc(w, arg.loc);
+            } else if constexpr (std::is_same_v<T, ast::LambdaExpression>) {
+                // lmd_expr_type is never populated by the parser and is not serialized
+                w.u8(static_cast<uint8_t>(ExprTag::Lambda));
+                write_iden(w, arg.arg);
+                write_type(w, arg.arg_type);
+                w.u32(arg.expr);
+                write_loc(w, arg.loc);
+            } else if constexpr (std::is_same_v<T, ast::FunctionApplication>) {
+                w.u8(static_cast<uint8_t>(ExprTag::FnApl));
+                write_iden(w, arg.fn_name);
+                w.u32(arg.args_begin);
+                w.u32(arg.args_count);
+                write_loc(w, arg.loc);
+            } else {
+                STATIC_ASSERT_UNREACHABLE_T(T, "unhandled expression");
+            }
+        }, expr.value);
+    }
+
+    static ast::ExprId read_expr_id(Reader &r, const ast::Arena &arena) {
+        const ast::ExprId id = r.u32();
+        if (id >= arena.exprs.size()) {
+            r.options_v.logger.error({}, "IO error: corrupt expression index ", id);
+        }
+        return id;
+    }
+
+    static ast::Expression read_expression(Reader &r, const ast::Arena &arena) {
+        switch (static_cast<ExprTag>(r.u8())) {
+            case ExprTag::Iden:
+                return ast::Expression(read_iden(r));
+            case ExprTag::String: {
+                std::string value = r.str();
+                return ast::Expression(ast::StringAstNode{std::move(value), read_loc(r)});
+            }
+            case ExprTag::Float: {
+                const double value = r.f64();
+                return ast::Expression(ast::FloatAstNode{value, read_loc(r)});
+            }
+            case ExprTag::Lambda: {
+                ast::IdenAstNode arg = read_iden(r);
+                intp::types::Type arg_type = read_type(r);
+                const ast::ExprId expr = read_expr_id(r, arena);
+                return ast::Expression(ast::LambdaExpression{
+                    .arg = std::move(arg), .arg_type = std::move(arg_type), .expr = expr, .loc = read_loc(r),
+                    .lmd_expr_type = {}
+                });
+            }
+            case ExprTag::FnApl: {
+                ast::IdenAstNode fn_name = read_iden(r);
+                const uint32_t args_begin = r.u32();
+                const uint32_t args_count = r.u32();
+                return ast::Expression(ast::FunctionApplication{std::move(fn_name), args_begin, args_count, read_loc(r)});
+            }
+            default:
+                r.options_v.logger.error({}, "IO error: corrupt expression tag at offset ", r.pos - 1);
+        }
+    }
+
+    void write_arena(Writer &w, const ast::Arena &arena) {
+        w.u32(static_cast<uint32_t>(arena.exprs.size()));
+        for (const auto &expr: arena.exprs) {
+            write_expression(w, expr);
+        }
+        w.u32(static_cast<uint32_t>(arena.args.size()));
+        w.buffer.append(reinterpret_cast<const char *>(arena.args.data()), arena.args.size() * sizeof(ast::ExprId));
+    }
+
+    ast::Arena read_arena(Reader &r) {
+        ast::Arena arena;
+        const uint32_t n = r.u32();
+        arena.exprs.reserve(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            arena.exprs.push_back(read_expression(r, arena));
+        }
+        const uint32_t args_count = r.u32();
+        arena.args.resize(args_count);
+        for (auto &arg: arena.args) {
+            if ((arg = r.u32()) >= n) {
+                r.options_v.logger.error({}, "IO error: corrupt argument index ", arg);
+            }
+        }
+        for (const auto &expr: arena.exprs) {
+            if (const auto *fn_apl = std::get_if<ast::FunctionApplication>(&expr.value);
+                fn_apl && static_cast<uint64_t>(fn_apl->args_begin) + fn_apl->args_count > args_count) {
+                r.options_v.logger.error({}, "IO error: corrupt argument range at ", fn_apl->loc);
+            }
+        }
+        return arena;
+    }
+
+    void write_ast_node(Writer &w, const ast::AstNode &node) {
+        if (const auto *expr = std::get_if<ast::ExprId>(&node.value)) {
+            w.u8(static_cast<uint8_t>(NodeTag::Expression));
+            w.u32(*expr);
+        } else {
+            const auto &def = std::get<ast::DefAstNode>(node.value);
+            w.u8(static_cast<uint8_t>(NodeTag::Def));
+            write_iden(w, def.def_name);
+            write_type(w, def.typ);
+            w.u32(def.expr);
+            write_loc(w, def.loc);
+        }
+    }
+
+    ast::AstNode read_ast_node(Reader &r, const ast::Arena &arena) {
+        if (static_cast<NodeTag>(r.u8()) == NodeTag::Expression) {
+            return ast::AstNode{read_expr_id(r, arena)};
+        }
+        ast::IdenAstNode def_name = read_iden(r);
+        intp::types::Type typ = read_type(r);
+        const ast::ExprId expr = read_expr_id(r, arena);
+        return ast::AstNode{ast::DefAstNode{std::move(def_name), std::move(typ), expr, read_loc(r)}};
+    }
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <lbd/fe/trace.h>
+
+namespace fe::trace {
+    struct Event {
+        std::string name;
+        const char *category;
+        uint64_t start_us;
+        uint64_t dur_us;
+        std::string args;
+    };
+
+    /// Owned by the registry so events outlive the worker thread that recorded them
+    struct Buffer {
+        uint32_t tid;
+        std::vector<Event> events;
+    };
+
+    static std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    static std::mutex registry_mutex; /// Taken once per thread and by write()
+    static std::deque<std::unique_ptr<Buffer> > registry;
+    static uint64_t generation = 0; /// Bumped by start(), invalidates every thread's cached Buffer
+
+    uint64_t now_us() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    void start() {
+        std::lock_guard lock(registry_mutex);
+        registry.clear();
+        ++generation;
+        epoch = std::chrono::steady_clock::now();
+        enabled = true;
+    }
+
+    void stop() {
+        enabled = false;
+    }
+
+    static Buffer &local_buffer() {
+        thread_local Buffer *buffer = nullptr;
+        thread_local uint64_t buffer_generation = 0;
+        if (!buffer || buffer_generation != generation) {
+            std::lock_guard lock(registry_mutex);
+            registry.push_back(std::make_unique<Buffer>(Buffer{static_cast<uint32_t>(registry.size() + 1), {}}));
+            buffer = registry.back().get();
+            buffer_generation = generation;
+        }
+        return *buffer;
+    }
+
+    void record(std::string name, const char *category, const uint64_t start_us, const uint64_t dur_us,
+                std::string args) {
+        local_buffer().events.push_back({std::move(name), category, start_us, dur_us, std::move(args)});
+    }
+
+    std::string quote(const std::string &value) {
+        static constexpr char hex[] = "0123456789abcdef";
+        std::string out = "\"";
+        for (const char c: value) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00";
+                out += hex[(c >> 4) & 0xf];
+                out += hex[c & 0xf];
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    void write(std::ostream &os) {
+        std::lock_guard lock(registry_mutex);
+        os << "{\"traceEvents\": [\n";
+        bool first = true;
+        for (const auto &buffer: registry) {
+            // The first thread to record is the one driving the run
+            os << (first ? "" : ",\n") << R"({"name": "thread_name", "ph": "M", "pid": 1, "tid": )" << buffer->tid
+                    << R"(, "args": {"name": )" << (buffer->tid == 1 ? "\"main\"" : "\"worker\"") << "}}";
+            first = false;
+            for (const auto &[name, category, start_us, dur_us, args]: buffer->events) {
+                os << ",\n{\"name\": " << quote(name) << ", \"cat\": \"" << category
+                        << R"(", "ph": "X", "pid": 1, "tid": )" << buffer->tid << ", \"ts\": " << start_us
+                        << ", \"dur\": " << dur_us;
+                if (!args.empty()) {
+                    os << ", \"args\": {" << args << "}";
+                }
+                os << "}";
+            }
+        }
+        os << "\n], \"displayTimeUnit\": \"ms\"}" << std::endl;
+    }
+}
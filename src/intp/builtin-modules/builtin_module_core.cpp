@@ -114,14 +114,15 @@ namespace intp::interp::builtins {
             1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
                             const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
                 const Value &arg0 = args[0]->force();
-                if (!std::holds_alternative<std::string>(arg0)) {
+                const std::string *text = text_of(arg0);
+                if (!text) {
                     options_v.logger.error({},
                                            "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name,
                                            " signature: String -> Float\n"
                                            "runtime error: expected String got ", arg0);
                 }
-                const std::string &s = std::get<std::string>(arg0);
+                const std::string &s = *text;
                 try {
                     const double value = std::stod(s);
                     return {Value{value}, ResultOptions{}};
@@ -0,0 +1,137 @@
+#include <unordered_map>
+#include <lbd/intp/builtin-modules/builtin_module_dict.h>
+#include <lbd/intp/builtin-modules/builtin_module_stream.h>
+
+namespace intp::interp::builtins {
+    static const Dict &dict_arg(const std::string &name, const char *signature, const Value &value) {
+        if (!std::holds_alternative<std::shared_ptr<Dict> >(value)) {
+            options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                   "\n", name, " signature: ", signature, "\n"
+                                   "runtime error: expected <Dict> got ", value);
+        }
+        return *std::get<std::shared_ptr<Dict> >(value);
+    }
+
+    // Only Floats and Strings hash structurally, a Rope hashes as the String it spells
+    static void check_key(const std::string &name, const Value &key) {
+        if (!std::holds_alternative<double>(key) && !text_of(key)) {
+            options_v.logger.error({}, "runtime error: native function ", name, " expects a Float or String key, got ",
+                                   key);
+        }
+    }
+
+    NativeFunction make_dict() {
+        const std::string name = "dict";
+        return {
+            -1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                             const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                if (args.size() % 2 != 0) {
+                    options_v.logger.error({}, "runtime error: native function ", name,
+                                           " expects alternating keys and values, got ", args.size(), " arguments");
+                }
+                auto dict = std::make_shared<Dict>();
+                for (size_t i = 0; i < args.size(); i += 2) {
+                    Value key = args[i]->force();
+                    check_key(name, key);
+                    dict->entries = dict->entries.insert(std::move(key), args[i + 1]->force());
+                }
+                return {Value{std::move(dict)}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_dict_get() {
+        const std::string name = "dict_get";
+        return {
+            3, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Dict &dict = dict_arg(name, "Dict -> K -> V -> V", args[0]->force());
+                const Value &key = args[1]->force();
+                check_key(name, key);
+                // The default is only forced on a miss
+                if (const Value *value = dict.entries.find(key)) {
+                    return {*value, ResultOptions{}};
+                }
+                return {args[2]->force(), ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_dict_put() {
+        const std::string name = "dict_put";
+        return {
+            3, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Dict &dict = dict_arg(name, "Dict -> K -> V -> Dict", args[0]->force());
+                Value key = args[1]->force();
+                check_key(name, key);
+                auto result = std::make_shared<Dict>(Dict{dict.entries.insert(std::move(key), args[2]->force())});
+                return {Value{std::move(result)}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_dict_keys() {
+        const std::string name = "dict_keys";
+        return {
+            1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Dict &dict = dict_arg(name, "Dict -> List", args[0]->force());
+                std::vector<Value> keys;
+                keys.reserve(dict.entries.size());
+                dict.entries.for_each([&](const Value &key, const Value &) {
+                    keys.push_back(key);
+                });
+                return {Value{std::make_shared<List>(std::move(keys))}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_frequencies() {
+        const std::string name = "frequencies";
+        return {
+            1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value source = fused_source(args[0]);
+                // Counting in a mutable table first builds each trie path once per distinct key
+                std::unordered_map<Value, double, ValueHash, ValueEq> counts;
+                for_each_element(name, source, [&](const Value &elem) {
+                    check_key(name, elem);
+                    ++counts[elem];
+                    return true;
+                });
+                auto dict = std::make_shared<Dict>();
+                for (const auto &[key, count]: counts) {
+                    dict->entries = dict->entries.insert(key, Value{count});
+                }
+                return {Value{std::move(dict)}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_group_by() {
+        const std::string name = "group_by";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &call_site_env) -> std::pair<Value, ResultOptions> {
+                const Value &fn_val = args[0]->force();
+                const Value source = fused_source(args[1]);
+                // Groups keep their elements in source order
+                std::unordered_map<Value, std::vector<Value>, ValueHash, ValueEq> groups;
+                for_each_element(name, source, [&](const Value &elem) {
+                    auto elem_thunk = std::make_shared<Thunk>();
+                    elem_thunk->cached = elem;
+                    Value key = apply_fn_apl(fn_val, {elem_thunk}, call_site_env);
+                    check_key(name, key);
+                    groups[std::move(key)].push_back(elem);
+                    return true;
+                });
+                auto dict = std::make_shared<Dict>();
+                for (auto &[key, elems]: groups) {
+                    dict->entries = dict->entries.insert(key, Value{std::make_shared<List>(std::move(elems))});
+                }
+                return {Value{std::move(dict)}, ResultOptions{}};
+            }
+        };
+    }
+}
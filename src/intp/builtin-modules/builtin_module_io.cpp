@@ -9,13 +9,14 @@ namespace intp::interp::builtins {
             1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
                             const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
                 const Value &arg0 = args[0]->force();
-                if (!std::holds_alternative<std::string>(arg0)) {
+                const std::string *path_text = text_of(arg0);
+                if (!path_text) {
                     options_v.logger.error({},
                                            "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name, " signature: String -> String\n"
                                            "runtime error: expected <String> got ", arg0);
                 }
-                const std::string &path = std::get<std::string>(arg0);
+                const std::string &path = *path_text;
                 std::ifstream file(path, std::ios::in | std::ios::binary);
                 if (!file) options_v.logger.error({}, "runtime error: could not open file ", path);
                 std::ostringstream buffer;
@@ -31,13 +32,14 @@ namespace intp::interp::builtins {
             1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
                             const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
                 const Value &arg0 = args[0]->force();
-                if (!std::holds_alternative<std::string>(arg0)) {
+                const std::string *input_text = text_of(arg0);
+                if (!input_text) {
                     options_v.logger.error({},
                                            "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name, " signature: String -> List<String>\n"
                                            "runtime error: expected <String> got ", arg0);
                 }
-                const auto input = std::get<std::string>(arg0);
+                const std::string &input = *input_text;
                 // Normalize all line endings to '\n'
                 std::string normalized;
                 normalized.reserve(input.size());
@@ -70,21 +72,23 @@ namespace intp::interp::builtins {
             2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
                             const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
                 const Value &arg0 = args[0]->force(); // string
-                if (!std::holds_alternative<std::string>(arg0)) {
+                const std::string *input_text = text_of(arg0);
+                if (!input_text) {
                     options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name,
                                            " signature: String -> String -> List<String>""\n"
                                            "runtime error: expected <String> got ", arg0);
                 }
                 const Value &arg1 = args[1]->force(); // delimiter
-                if (!std::holds_alternative<std::string>(arg1)) {
+                const std::string *delim_text = text_of(arg1);
+                if (!delim_text) {
                     options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name,
                                            " signature: String -> String -> List""\n"
                                            "runtime error: expected <String> got ", arg1);
                 }
-                const std::string &input = std::get<std::string>(arg0);
-                const std::string &delim = std::get<std::string>(arg1);
+                const std::string &input = *input_text;
+                const std::string &delim = *delim_text;
                 if (delim.empty()) {
                     options_v.logger.error({}, "runtime error: delimiter for ", name, " cannot be empty");
                 }
@@ -1,28 +1,91 @@
+#include <array>
 #include <lbd/intp/builtin-modules/builtin_module_list.h>
+#include <lbd/intp/builtin-modules/builtin_module_stream.h>
+#include <lbd/intp/cow.h>
+#include <lbd/utils/sort.h>
 
 namespace intp::interp::builtins {
+    /// Numeric Lists at least this long are sorted by radix sort instead of std::sort, both by float_order_key
+    static constexpr size_t RADIX_SORT_MIN = 1024;
+
+    // Orders Floats by float_order_key like sort does, Strings and Lists lexicographically and Values of different types by type.
+    // Ropes order as the Strings they spell. Closures and Native Functions compare equal.
+    static int compare_values(const Value &a, const Value &b) {
+        if (const std::string *x = text_of(a), *y = text_of(b); x && y) {
+            const int order = x->compare(*y);
+            return (order > 0) - (order < 0);
+        }
+        if (a.index() != b.index()) {
+            return a.index() < b.index() ? -1 : 1;
+        }
+        if (const auto *x = std::get_if<double>(&a)) {
+            const uint64_t kx = float_order_key(*x), ky = float_order_key(std::get<double>(b));
+            return (kx > ky) - (kx < ky);
+        }
+        if (const auto *x = std::get_if<std::shared_ptr<List> >(&a)) {
+            const auto &y = std::get<std::shared_ptr<List> >(b);
+            const size_t n = std::min((*x)->size(), y->size());
+            for (size_t i = 0; i < n; ++i) {
+                if (const int order = compare_values((*x)->at(i), y->at(i)); order != 0) {
+                    return order;
+                }
+            }
+            return ((*x)->size() > y->size()) - ((*x)->size() < y->size());
+        }
+        return 0;
+    }
+
+    // Flattens every Rope within value, so comparisons on sorting threads only read them
+    static void flatten_ropes(const Value &value) {
+        if (const auto *rope = std::get_if<std::shared_ptr<Rope> >(&value)) {
+            (*rope)->flat();
+        } else if (const auto *list = std::get_if<std::shared_ptr<List> >(&value); list && !(*list)->numeric) {
+            for (const auto &element: (*list)->elements) {
+                flatten_ropes(element);
+            }
+        }
+    }
+
+    // Sorting compares on worker threads that cannot report errors, so element types are checked up front
+    static void check_sortable(const std::string &name, const Value &first, const Value &value) {
+        flatten_ropes(value);
+        const bool text = text_of(value) != nullptr;
+        const bool orderable = text || std::holds_alternative<double>(value) ||
+                               std::holds_alternative<std::shared_ptr<List> >(value);
+        const bool same_type = text ? text_of(first) != nullptr : value.index() == first.index();
+        if (!orderable || !same_type) {
+            options_v.logger.error({}, "runtime error: native function ", name,
+                                   " expects Floats, Strings or Lists of a single type, but got ", value);
+        }
+    }
     static Value list_get(const std::shared_ptr<List> &list_v, size_t index) {
-        if (index >= list_v->elements.size()) {
+        if (index >= list_v->size()) {
             options_v.logger.error({}, "runtime error: list index out of range, index is ", index);
         }
-        return list_v->elements[index];
+        return list_v->at(index);
     }
 
     static Value list_remove(const std::shared_ptr<List> &list_v, size_t index) {
-        if (index >= list_v->elements.size()) {
+        if (index >= list_v->size()) {
             options_v.logger.error({}, "runtime error: list index out of range, index is ", index);
         }
-        Value value = list_v->elements[index];
-        list_v->elements.erase(list_v->elements.begin() + static_cast<std::vector<Value>::difference_type>(index));
+        if (list_v->frozen) {
+            cow::before_write(list_v);
+        }
+        Value value = list_v->at(index);
+        *list_v = list_v->erase(index);
         return value;
     }
 
     static void list_append(const std::shared_ptr<List> &list_v, Value value) {
-        list_v->elements.push_back(std::move(value));
+        if (list_v->frozen) {
+            cow::before_write(list_v);
+        }
+        *list_v = list_v->push_back(std::move(value));
     }
 
     std::shared_ptr<List> make_list_obj(const std::vector<Value> &elements) {
-        return std::make_shared<List>(List{elements});
+        return std::make_shared<List>(elements);
     }
 
     NativeFunction make_list() {
@@ -52,7 +115,7 @@ namespace intp::interp::builtins {
                                            "runtime error: expected <List> got ", arg0);
                 }
                 const auto list_v = std::get<std::shared_ptr<List> >(arg0);
-                return std::make_pair(Value{static_cast<double>(list_v->elements.size())}, ResultOptions{});
+                return std::make_pair(Value{static_cast<double>(list_v->size())}, ResultOptions{});
             }
         };
     }
@@ -67,21 +130,11 @@ namespace intp::interp::builtins {
                 if (!std::holds_alternative<std::shared_ptr<List> >(arg0)) {
                     options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name,
-                                           " signature: List -> Float -> List""\n"
+                                           " signature: List -> Float -> Any""\n"
                                            "runtime error: expected <List> got ", arg0);
                 }
-                const Value &arg1 = args[1]->force();
-                if (!std::holds_alternative<double>(arg1)) {
-                    options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
-                                           "\n", name,
-                                           " signature: List -> Float -> List""\n"
-                                           "runtime error: expected <Float> got ", arg1);
-                }
-                return std::make_pair(Value{
-                                          list_get(std::get<std::shared_ptr<List> >(arg0),
-                                                   static_cast<size_t>(std::get<double>(arg1)))
-                                      },
-                                      ResultOptions{});
+                const size_t index = index_arg(name, "List -> Float -> Any", args[1]->force());
+                return std::make_pair(Value{list_get(std::get<std::shared_ptr<List> >(arg0), index)}, ResultOptions{});
             }
         };
     }
@@ -96,21 +149,12 @@ namespace intp::interp::builtins {
                 if (!std::holds_alternative<std::shared_ptr<List> >(arg0)) {
                     options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name,
-                                           " signature: List -> Float -> List""\n"
+                                           " signature: List -> Float -> Any""\n"
                                            "runtime error: expected <List> got ", arg0);
                 }
-                const Value &arg1 = args[1]->force();
-                if (!std::holds_alternative<double>(arg1)) {
-                    options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
-                                           "\n", name,
-                                           " signature: List -> Float -> List""\n"
-                                           "runtime error: expected <Float> got ", arg1);
-                }
-                return std::make_pair(
-                    Value{
-                        list_remove(std::get<std::shared_ptr<List> >(arg0), static_cast<size_t>(std::get<double>(arg1)))
-                    },
-                    ResultOptions{});
+                const size_t index = index_arg(name, "List -> Float -> Any", args[1]->force());
+                return std::make_pair(Value{list_remove(std::get<std::shared_ptr<List> >(arg0), index)},
+                                      ResultOptions{});
             }
         };
     }
@@ -140,24 +184,24 @@ namespace intp::interp::builtins {
             2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
                             const std::shared_ptr<Env> &call_site_env) -> std::pair<Value, ResultOptions> {
                 const Value &fn_val = args[0]->force();
-                const Value &list_val = args[1]->force();
-                if (!std::holds_alternative<std::shared_ptr<List> >(list_val)) {
+                const Value list_val = fused_source(args[1]);
+                if (!std::holds_alternative<std::shared_ptr<List> >(list_val) &&
+                    !std::holds_alternative<std::shared_ptr<Stream> >(list_val)) {
                     options_v.logger.error({},
                                            "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name,
                                            " signature: (A -> B) -> List<A> -> List<B>\n"
                                            "runtime error: expected List<A> got ", list_val);
                 }
-                const auto list_v = std::get<std::shared_ptr<List> >(list_val);
                 std::vector<Value> results;
-                results.reserve(list_v->elements.size());
-                for (auto &elem: list_v->elements) {
+                for_each_element(name, list_val, [&](const Value &elem) {
                     auto elem_thunk = std::make_shared<Thunk>();
                     elem_thunk->cached = elem;
                     // TODO: Accumulate ResultOptions from apply_fn_apl
                     auto mapped_val = apply_fn_apl(fn_val, {elem_thunk}, call_site_env);
                     results.push_back(mapped_val);
-                }
+                    return true;
+                });
                 return {Value{std::make_shared<List>(List{std::move(results)})}, ResultOptions{}};
             }
         };
@@ -177,12 +221,12 @@ namespace intp::interp::builtins {
                                            "runtime error: expected List got ", arg0);
                 }
                 const auto outer_list = std::get<std::shared_ptr<List> >(arg0);
-                if (outer_list->elements.empty()) return {Value{std::make_shared<List>(List{})}, ResultOptions{}};
+                if (outer_list->empty()) return {Value{std::make_shared<List>(List{})}, ResultOptions{}};
                 // Ensure all elements are lists
                 std::vector<std::shared_ptr<List> > rows;
-                rows.reserve(outer_list->elements.size());
+                rows.reserve(outer_list->size());
                 size_t min_size = SIZE_MAX;
-                for (auto &elem: outer_list->elements) {
+                outer_list->for_each([&](const Value &elem) {
                     if (!std::holds_alternative<std::shared_ptr<List> >(elem)) {
                         options_v.logger.error({},
                                                "runtime error: native function ", name,
@@ -190,8 +234,8 @@ namespace intp::interp::builtins {
                     }
                     auto row = std::get<std::shared_ptr<List> >(elem);
                     rows.push_back(row);
-                    min_size = std::min(min_size, row->elements.size());
-                }
+                    min_size = std::min(min_size, row->size());
+                });
                 // Build columns
                 std::vector<Value> transposed;
                 transposed.reserve(min_size);
@@ -199,7 +243,7 @@ namespace intp::interp::builtins {
                     std::vector<Value> column;
                     column.reserve(rows.size());
                     for (const auto &row: rows) {
-                        column.push_back(row->elements[col]);
+                        column.push_back(row->at(col));
                     }
                     transposed.emplace_back(std::make_shared<List>(List{std::move(column)}));
                 }
@@ -218,28 +262,107 @@ namespace intp::interp::builtins {
                     options_v.logger.error({},
                                            "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name,
-                                           " signature: List<Float> -> List<Float>\n"
-                                           "runtime error: expected List<Float> got ", arg0);
+                                           " signature: List<A> -> List<A>\n"
+                                           "runtime error: expected List<A> got ", arg0);
                 }
                 const auto list_v = std::get<std::shared_ptr<List> >(arg0);
-                // Ensure all elements are floats
-                std::vector<double> floats;
-                floats.reserve(list_v->elements.size());
-                for (auto &elem: list_v->elements) {
-                    if (!std::holds_alternative<double>(elem)) {
-                        options_v.logger.error({},
-                                               "runtime error: native function ", name,
-                                               "expects List of Float, but got element ", elem);
+                if (list_v->numeric) {
+                    std::vector<double> floats = list_v->floats.to_vector();
+                    if (floats.size() >= RADIX_SORT_MIN) {
+                        radix_sort(floats);
+                    } else {
+                        std::sort(floats.begin(), floats.end(), float_order_less);
                     }
-                    floats.push_back(std::get<double>(elem));
+                    return {Value{std::make_shared<List>(std::move(floats))}, ResultOptions{}};
+                }
+                std::vector<Value> values = list_v->elements.to_vector();
+                for (const auto &value: values) {
+                    check_sortable(name, values.front(), value);
+                }
+                parallel_stable_sort(values, [](const Value &a, const Value &b) {
+                    return compare_values(a, b) < 0;
+                });
+                return {Value{std::make_shared<List>(std::move(values))}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_sort_by() {
+        const std::string name = "sort_by";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &call_site_env) -> std::pair<Value, ResultOptions> {
+                const Value &fn_val = args[0]->force();
+                const Value &list_val = args[1]->force();
+                if (!std::holds_alternative<std::shared_ptr<List> >(list_val)) {
+                    options_v.logger.error({},
+                                           "runtime error: wrong arguments provided to native function ", name,
+                                           "\n", name,
+                                           " signature: (A -> B) -> List<A> -> List<A>\n"
+                                           "runtime error: expected List<A> got ", list_val);
+                }
+                const auto list_v = std::get<std::shared_ptr<List> >(list_val);
+                std::vector<Value> values;
+                values.reserve(list_v->size());
+                list_v->for_each([&](const Value &elem) {
+                    values.push_back(elem);
+                });
+                // Decorate every element with its key once, sort the pairs, then drop the keys
+                std::vector<std::pair<Value, size_t> > keyed;
+                keyed.reserve(values.size());
+                for (size_t i = 0; i < values.size(); ++i) {
+                    auto elem_thunk = std::make_shared<Thunk>();
+                    elem_thunk->cached = values[i];
+                    keyed.emplace_back(apply_fn_apl(fn_val, {elem_thunk}, call_site_env), i);
+                    check_sortable(name, keyed.front().first, keyed.back().first);
                 }
-                std::sort(floats.begin(), floats.end());
+                parallel_stable_sort(keyed, [](const std::pair<Value, size_t> &a, const std::pair<Value, size_t> &b) {
+                    return compare_values(a.first, b.first) < 0;
+                });
                 std::vector<Value> sorted;
-                sorted.reserve(floats.size());
-                for (double f: floats) {
-                    sorted.emplace_back(f);
+                sorted.reserve(keyed.size());
+                for (const auto &[_, i]: keyed) {
+                    sorted.push_back(std::move(values[i]));
                 }
-                return {Value{std::make_shared<List>(List{std::move(sorted)})}, ResultOptions{}};
+                return {Value{std::make_shared<List>(std::move(sorted))}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_sort_with() {
+        const std::string name = "sort_with";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &call_site_env) -> std::pair<Value, ResultOptions> {
+                const Value &fn_val = args[0]->force();
+                const Value &list_val = args[1]->force();
+                if (!std::holds_alternative<std::shared_ptr<List> >(list_val)) {
+                    options_v.logger.error({},
+                                           "runtime error: wrong arguments provided to native function ", name,
+                                           "\n", name,
+                                           " signature: (A -> A -> Float) -> List<A> -> List<A>\n"
+                                           "runtime error: expected List<A> got ", list_val);
+                }
+                const auto list_v = std::get<std::shared_ptr<List> >(list_val);
+                std::vector<Value> values;
+                values.reserve(list_v->size());
+                list_v->for_each([&](const Value &elem) {
+                    values.push_back(elem);
+                });
+                // The comparator runs on the interpreter, so this sort stays on the calling thread
+                std::stable_sort(values.begin(), values.end(), [&](const Value &a, const Value &b) {
+                    auto a_thunk = std::make_shared<Thunk>();
+                    a_thunk->cached = a;
+                    auto b_thunk = std::make_shared<Thunk>();
+                    b_thunk->cached = b;
+                    const Value order = apply_fn_apl(fn_val, {a_thunk, b_thunk}, call_site_env);
+                    if (!std::holds_alternative<double>(order)) {
+                        options_v.logger.error({}, "runtime error: native function ", name,
+                                               " expects the comparator to return a Float, but got ", order);
+                    }
+                    return std::get<double>(order) < 0;
+                });
+                return {Value{std::make_shared<List>(std::move(values))}, ResultOptions{}};
             }
         };
     }
@@ -258,14 +381,14 @@ namespace intp::interp::builtins {
                                            "runtime error: expected List<List> got ", arg0);
                 }
                 const auto outer_list = std::get<std::shared_ptr<List> >(arg0);
-                if (outer_list->elements.empty()) {
+                if (outer_list->empty()) {
                     return {Value{std::make_shared<List>(List{})}, ResultOptions{}};
                 }
                 // Ensure all elements are lists
                 std::vector<std::shared_ptr<List> > lists;
-                lists.reserve(outer_list->elements.size());
+                lists.reserve(outer_list->size());
                 size_t min_size = SIZE_MAX;
-                for (auto &elem: outer_list->elements) {
+                outer_list->for_each([&](const Value &elem) {
                     if (!std::holds_alternative<std::shared_ptr<List> >(elem)) {
                         options_v.logger.error({},
                                                "runtime error: native function ", name,
@@ -273,15 +396,15 @@ namespace intp::interp::builtins {
                     }
                     auto list = std::get<std::shared_ptr<List> >(elem);
                     lists.push_back(list);
-                    min_size = std::min(min_size, list->elements.size());
-                }
+                    min_size = std::min(min_size, list->size());
+                });
                 // Build zipped result
                 std::vector<Value> zipped;
                 zipped.reserve(min_size);
                 for (size_t i = 0; i < min_size; ++i) {
                     std::vector<Value> tuple;
                     tuple.reserve(lists.size());
-                    for (const auto &list: lists) tuple.push_back(list->elements[i]);
+                    for (const auto &list: lists) tuple.push_back(list->at(i));
                     zipped.emplace_back(std::make_shared<List>(List{std::move(tuple)}));
                 }
                 return {Value{std::make_shared<List>(List{std::move(zipped)})}, ResultOptions{}};
@@ -294,30 +417,284 @@ namespace intp::interp::builtins {
         return {
             3, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
                             const std::shared_ptr<Env> &call_site_env) -> std::pair<Value, ResultOptions> {
-                const Value &fn_val = args[0]->force();
+                RepeatedCall fn(args[0]->force(), call_site_env, 2);
                 const Value &init_val = args[1]->force();
-                const Value &list_val = args[2]->force();
-                if (!std::holds_alternative<std::shared_ptr<List> >(list_val)) {
+                const Value list_val = fused_source(args[2]);
+                if (!std::holds_alternative<std::shared_ptr<List> >(list_val) &&
+                    !std::holds_alternative<std::shared_ptr<Stream> >(list_val)) {
                     options_v.logger.error({},
                                            "runtime error: wrong arguments provided to native function ", name,
                                            "\n", name,
                                            " signature: (A -> B -> B) -> List<A> -> B -> B\n"
                                            "runtime error: expected List<A> got ", list_val);
                 }
-                const auto list_v = std::get<std::shared_ptr<List> >(list_val);
-                // Start with the initial accumulator value
-                Value acc = init_val;
+                // fn takes (element, accumulator), starting with the initial accumulator value
+                std::array<Value, 2> step_args{Value{}, init_val};
+                const auto step = [&](const Value &elem) {
+                    step_args[0] = elem;
+                    step_args[1] = fn(step_args);
+                };
                 // Traverse from the last element to the first
-                for (auto it = list_v->elements.rbegin(); it != list_v->elements.rend(); ++it) {
-                    auto elem_thunk = std::make_shared<Thunk>();
-                    elem_thunk->cached = *it;
-                    auto acc_thunk = std::make_shared<Thunk>();
-                    acc_thunk->cached = acc;
-                    // fn takes (element, accumulator)
-                    acc = apply_fn_apl(fn_val, {elem_thunk, acc_thunk}, call_site_env);
+                if (std::holds_alternative<std::shared_ptr<Stream> >(list_val)) {
+                    // A fused pipeline only runs forward, its final elements are buffered without building a List
+                    std::vector<Value> elements;
+                    for_each_element(name, list_val, [&](const Value &elem) {
+                        elements.push_back(elem);
+                        return true;
+                    });
+                    for (auto it = elements.rbegin(); it != elements.rend(); ++it) {
+                        step(*it);
+                    }
+                } else if (const auto &list_v = std::get<std::shared_ptr<List> >(list_val); list_v->numeric) {
+                    for (auto it = list_v->floats.rbegin(); it != list_v->floats.rend(); ++it) {
+                        step(Value{*it});
+                    }
+                } else {
+                    for (auto it = list_v->elements.rbegin(); it != list_v->elements.rend(); ++it) {
+                        step(*it);
+                    }
+                }
+                return {std::move(step_args[1]), ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_push() {
+        const std::string name = "push";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value &arg0 = args[0]->force();
+                if (!std::holds_alternative<std::shared_ptr<List> >(arg0)) {
+                    options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                           "\n", name,
+                                           " signature: List -> Any -> List""\n"
+                                           "runtime error: expected <List> got ", arg0);
+                }
+                const auto list_v = std::get<std::shared_ptr<List> >(arg0);
+                return {
+                    Value{std::make_shared<List>(list_v->push_back(args[1]->force()))},
+                    ResultOptions{}
+                };
+            }
+        };
+    }
+
+    NativeFunction make_set() {
+        const std::string name = "set";
+        return {
+            3, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value &arg0 = args[0]->force();
+                if (!std::holds_alternative<std::shared_ptr<List> >(arg0)) {
+                    options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                           "\n", name,
+                                           " signature: List -> Float -> Any -> List""\n"
+                                           "runtime error: expected <List> got ", arg0);
+                }
+                const auto list_v = std::get<std::shared_ptr<List> >(arg0);
+                const size_t index = index_arg(name, "List -> Float -> Any -> List", args[1]->force());
+                if (index >= list_v->size()) {
+                    options_v.logger.error({}, "runtime error: list index out of range, index is ", index);
+                }
+                return {
+                    Value{std::make_shared<List>(list_v->set(index, args[2]->force()))},
+                    ResultOptions{}
+                };
+            }
+        };
+    }
+
+    static bool is_text(const Value &value) {
+        return std::holds_alternative<std::string>(value) || std::holds_alternative<std::shared_ptr<Rope> >(value);
+    }
+
+    static std::shared_ptr<Rope> rope_of(const Value &value) {
+        if (const auto *rope = std::get_if<std::shared_ptr<Rope> >(&value)) {
+            return *rope;
+        }
+        return std::make_shared<Rope>(std::get<std::string>(value));
+    }
+
+    NativeFunction make_concat() {
+        const std::string name = "concat";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value &arg0 = args[0]->force();
+                const Value &arg1 = args[1]->force();
+                // Texts join into a Rope, which links an existing Rope instead of copying it
+                if (is_text(arg0) && is_text(arg1)) {
+                    return {Value{Rope::concat(rope_of(arg0), rope_of(arg1))}, ResultOptions{}};
+                }
+                for (const Value *arg: {&arg0, &arg1}) {
+                    if (!std::holds_alternative<std::shared_ptr<List> >(*arg)) {
+                        options_v.logger.error({}, "runtime error: wrong arguments provided to native function ",
+                                               name, "\n", name,
+                                               " signature: List -> List -> List | String -> String -> String""\n"
+                                               "runtime error: expected <List> got ", *arg);
+                    }
+                }
+                return {
+                    Value{
+                        std::make_shared<List>(List::concat(*std::get<std::shared_ptr<List> >(arg0),
+                                                           *std::get<std::shared_ptr<List> >(arg1)))
+                    },
+                    ResultOptions{}
+                };
+            }
+        };
+    }
+
+    NativeFunction make_slice() {
+        const std::string name = "slice";
+        return {
+            3, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value &arg0 = args[0]->force();
+                if (!std::holds_alternative<std::shared_ptr<List> >(arg0)) {
+                    options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                           "\n", name,
+                                           " signature: List -> Float -> Float -> List""\n"
+                                           "runtime error: expected <List> got ", arg0);
                 }
-                return {acc, ResultOptions{}};
+                const auto list_v = std::get<std::shared_ptr<List> >(arg0);
+                const size_t begin = index_arg(name, "List -> Float -> Float -> List", args[1]->force());
+                const size_t end = index_arg(name, "List -> Float -> Float -> List", args[2]->force());
+                if (begin > end || end > list_v->size()) {
+                    options_v.logger.error({}, "runtime error: list slice out of range, slice is [", begin, ", ", end,
+                                           ") of ", list_v->size());
+                }
+                return {Value{std::make_shared<List>(list_v->slice(begin, end))}, ResultOptions{}};
+            }
+        };
+    }
+
+    static const List &sorted_list_arg(const std::string &name, const char *signature, const Value &value) {
+        if (!std::holds_alternative<std::shared_ptr<List> >(value)) {
+            options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                   "\n", name, " signature: ", signature, "\n"
+                                   "runtime error: expected <List> got ", value);
+        }
+        return *std::get<std::shared_ptr<List> >(value);
+    }
+
+    // Index of the first element not ordered before target, or ordered after it when upper.
+    // Floats compare by float_order_less, so Lists sort produced with -0.0 or NaNs in them stay partitioned.
+    static size_t bound(const List &list, const Value &target, const bool upper) {
+        if (list.numeric && std::holds_alternative<double>(target)) {
+            const double x = std::get<double>(target);
+            if (upper) {
+                return list.floats.partition_point([x](const double value) { return !float_order_less(x, value); });
+            }
+            return list.floats.partition_point([x](const double value) { return float_order_less(value, x); });
+        }
+        const auto before = [&](const Value &value) {
+            const int order = compare_values(value, target);
+            return upper ? order <= 0 : order < 0;
+        };
+        if (list.numeric) {
+            return list.floats.partition_point([&](const double value) { return before(Value{value}); });
+        }
+        return list.elements.partition_point(before);
+    }
+
+    // Binary search on a List sorted ascending, as by sort
+    static NativeFunction make_search(const std::string &name,
+                                      const std::function<double(const List &, const Value &)> &search) {
+        return {
+            2, name, [name, search](const std::vector<std::shared_ptr<Thunk> > &args,
+                                    const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const List &list = sorted_list_arg(name, "List<A> -> A -> Float", args[0]->force());
+                return {Value{search(list, args[1]->force())}, ResultOptions{}};
             }
         };
     }
+
+    NativeFunction make_bsearch() {
+        return make_search("bsearch", [](const List &list, const Value &target) {
+            const size_t index = bound(list, target, false);
+            return index < list.size() && compare_values(list.at(index), target) == 0
+                       ? static_cast<double>(index)
+                       : -1.0;
+        });
+    }
+
+    NativeFunction make_lower_bound() {
+        return make_search("lower_bound", [](const List &list, const Value &target) {
+            return static_cast<double>(bound(list, target, false));
+        });
+    }
+
+    NativeFunction make_upper_bound() {
+        return make_search("upper_bound", [](const List &list, const Value &target) {
+            return static_cast<double>(bound(list, target, true));
+        });
+    }
+
+    NativeFunction make_unique() {
+        const std::string name = "unique";
+        return {
+            1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const List &list = sorted_list_arg(name, "List<A> -> List<A>", args[0]->force());
+                if (list.numeric) {
+                    std::vector<double> floats = list.floats.to_vector();
+                    dedupe_adjacent(floats);
+                    return {Value{std::make_shared<List>(std::move(floats))}, ResultOptions{}};
+                }
+                std::vector<Value> values = list.elements.to_vector();
+                values.erase(std::unique(values.begin(), values.end(), [](const Value &a, const Value &b) {
+                    return compare_values(a, b) == 0;
+                }), values.end());
+                return {Value{std::make_shared<List>(std::move(values))}, ResultOptions{}};
+            }
+        };
+    }
+
+    using FloatMerge = std::vector<double> (*)(const std::vector<double> &, const std::vector<double> &);
+
+    // Linear merge of two Lists sorted ascending, Lists of Floats use the branch-free kernels of sort.h
+    template<typename ValueMerge>
+    static NativeFunction make_merge(const std::string &name, const FloatMerge float_merge,
+                                     const ValueMerge value_merge) {
+        return {
+            2, name, [name, float_merge, value_merge](const std::vector<std::shared_ptr<Thunk> > &args,
+                                                      const std::shared_ptr<Env> &)
+                -> std::pair<Value, ResultOptions> {
+                const List &x = sorted_list_arg(name, "List<A> -> List<A> -> List<A>", args[0]->force());
+                const List &y = sorted_list_arg(name, "List<A> -> List<A> -> List<A>", args[1]->force());
+                if (x.numeric && y.numeric) {
+                    return {
+                        Value{std::make_shared<List>(float_merge(x.floats.to_vector(), y.floats.to_vector()))},
+                        ResultOptions{}
+                    };
+                }
+                const std::vector<Value> xs = x.boxed().to_vector();
+                const std::vector<Value> ys = y.boxed().to_vector();
+                std::vector<Value> values;
+                value_merge(xs.begin(), xs.end(), ys.begin(), ys.end(), std::back_inserter(values),
+                            [](const Value &a, const Value &b) { return compare_values(a, b) < 0; });
+                return {Value{std::make_shared<List>(std::move(values))}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_intersect() {
+        return make_merge("intersect", merge_intersect, [](auto... merge_args) {
+            return std::set_intersection(merge_args...);
+        });
+    }
+
+    NativeFunction make_union() {
+        return make_merge("union", merge_union, [](auto... merge_args) {
+            return std::set_union(merge_args...);
+        });
+    }
+
+    NativeFunction make_difference() {
+        return make_merge("difference", merge_difference, [](auto... merge_args) {
+            return std::set_difference(merge_args...);
+        });
+    }
 }
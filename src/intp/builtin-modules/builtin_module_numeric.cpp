@@ -0,0 +1,171 @@
+#include <lbd/intp/builtin-modules/builtin_module_numeric.h>
+#include <lbd/intp/simd.h>
+
+namespace intp::interp::builtins {
+    using Reduction = double (*)(const double *, size_t);
+    using Elementwise = void (*)(const double *, const double *, double *, size_t);
+
+    static const List &float_list_arg(const std::string &name, const char *signature, const Value &arg) {
+        if (!std::holds_alternative<std::shared_ptr<List> >(arg)) {
+            options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                   "\n", name, " signature: ", signature, "\n"
+                                   "runtime error: expected List<Float> got ", arg);
+        }
+        return *std::get<std::shared_ptr<List> >(arg);
+    }
+
+    // A numeric List is read in place one chunk at a time, a generic one is checked and copied once
+    template<typename F>
+    static void for_each_float_chunk(const std::string &name, const List &list, F &&fn) {
+        if (list.numeric) {
+            list.floats.for_each_chunk(fn);
+            return;
+        }
+        std::vector<double> values;
+        values.reserve(list.size());
+        for (const auto &elem: list.elements) {
+            if (!std::holds_alternative<double>(elem)) {
+                options_v.logger.error({}, "runtime error: native function ", name,
+                                       " expects List of Float, but got element ", elem);
+            }
+            values.push_back(std::get<double>(elem));
+        }
+        fn(std::span<const double>(values));
+    }
+
+    static std::vector<double> float_values(const std::string &name, const List &list) {
+        std::vector<double> values;
+        values.reserve(list.size());
+        for_each_float_chunk(name, list, [&](const std::span<const double> chunk) {
+            values.insert(values.end(), chunk.begin(), chunk.end());
+        });
+        return values;
+    }
+
+    // Reduces every chunk with kernel and folds the partial results with combine.
+    // min and max combine with their own kernel, so a NaN partial stays NaN.
+    static NativeFunction make_reduction(const std::string &name, const Reduction kernel, const Reduction combine,
+                                         const bool allow_empty) {
+        return {
+            1, name, [name, kernel, combine, allow_empty](const std::vector<std::shared_ptr<Thunk> > &args,
+                                                          const std::shared_ptr<Env> &)
+                -> std::pair<Value, ResultOptions> {
+                const List &list = float_list_arg(name, "List<Float> -> Float", args[0]->force());
+                if (list.empty() && !allow_empty) {
+                    options_v.logger.error({}, "runtime error: native function ", name, " of an empty List");
+                }
+                std::vector<double> partials;
+                for_each_float_chunk(name, list, [&](const std::span<const double> chunk) {
+                    partials.push_back(kernel(chunk.data(), chunk.size()));
+                });
+                return {Value{combine(partials.data(), partials.size())}, ResultOptions{}};
+            }
+        };
+    }
+
+    static NativeFunction make_elementwise(const std::string &name, const Elementwise kernel) {
+        return {
+            2, name, [name, kernel](const std::vector<std::shared_ptr<Thunk> > &args,
+                                    const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const char *signature = "List<Float> -> List<Float> -> List<Float>";
+                std::vector<double> xs = float_values(name, float_list_arg(name, signature, args[0]->force()));
+                const std::vector<double> ys = float_values(name, float_list_arg(name, signature, args[1]->force()));
+                if (xs.size() != ys.size()) {
+                    options_v.logger.error({}, "runtime error: native function ", name,
+                                           " expects Lists of equal size, got ", xs.size(), " and ", ys.size());
+                }
+                kernel(xs.data(), ys.data(), xs.data(), xs.size());
+                return {Value{std::make_shared<List>(std::move(xs))}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_sum() {
+        return make_reduction("sum", simd::sum, simd::sum, true);
+    }
+
+    NativeFunction make_product() {
+        return make_reduction("product", simd::product, simd::product, true);
+    }
+
+    NativeFunction make_min() {
+        return make_reduction("min", simd::min, simd::min, false);
+    }
+
+    NativeFunction make_max() {
+        return make_reduction("max", simd::max, simd::max, false);
+    }
+
+    NativeFunction make_mean() {
+        const std::string name = "mean";
+        return {
+            1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const List &list = float_list_arg(name, "List<Float> -> Float", args[0]->force());
+                if (list.empty()) {
+                    options_v.logger.error({}, "runtime error: native function ", name, " of an empty List");
+                }
+                double total = 0;
+                for_each_float_chunk(name, list, [&](const std::span<const double> chunk) {
+                    total += simd::sum(chunk.data(), chunk.size());
+                });
+                return {Value{total / static_cast<double>(list.size())}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_dot() {
+        const std::string name = "dot";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const char *signature = "List<Float> -> List<Float> -> Float";
+                const List &xs = float_list_arg(name, signature, args[0]->force());
+                const std::vector<double> ys = float_values(name, float_list_arg(name, signature, args[1]->force()));
+                if (xs.size() != ys.size()) {
+                    options_v.logger.error({}, "runtime error: native function ", name,
+                                           " expects Lists of equal size, got ", xs.size(), " and ", ys.size());
+                }
+                // Walk the chunks of xs against the matching slices of the contiguous ys
+                double total = 0;
+                size_t offset = 0;
+                for_each_float_chunk(name, xs, [&](const std::span<const double> chunk) {
+                    total += simd::dot(chunk.data(), ys.data() + offset, chunk.size());
+                    offset += chunk.size();
+                });
+                return {Value{total}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_vadd() {
+        return make_elementwise("vadd", simd::add);
+    }
+
+    NativeFunction make_vsub() {
+        return make_elementwise("vsub", simd::sub);
+    }
+
+    NativeFunction make_vmul() {
+        return make_elementwise("vmul", simd::mul);
+    }
+
+    NativeFunction make_vscale() {
+        const std::string name = "vscale";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value &arg0 = args[0]->force();
+                if (!std::holds_alternative<double>(arg0)) {
+                    options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                           "\n", name, " signature: Float -> List<Float> -> List<Float>\n"
+                                           "runtime error: expected <Float> got ", arg0);
+                }
+                std::vector<double> xs = float_values(
+                    name, float_list_arg(name, "Float -> List<Float> -> List<Float>", args[1]->force()));
+                simd::scale(std::get<double>(arg0), xs.data(), xs.data(), xs.size());
+                return {Value{std::make_shared<List>(std::move(xs))}, ResultOptions{}};
+            }
+        };
+    }
+}
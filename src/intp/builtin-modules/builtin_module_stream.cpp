@@ -0,0 +1,341 @@
+#include <array>
+#include <lbd/intp/builtin-modules/builtin_module_stream.h>
+
+namespace intp::interp::builtins {
+    /// Produces the next element of a traversal, or nullopt once it is exhausted
+    using Cursor = std::function<std::optional<Value>()>;
+
+    static Value call(const Stream &stream, Value arg) {
+        auto arg_thunk = std::make_shared<Thunk>();
+        arg_thunk->cached = std::move(arg);
+        return apply_fn_apl(stream.fn, {arg_thunk}, stream.env);
+    }
+
+    // Predicates keep an element by returning a non-zero Float
+    static bool holds(const Stream &stream, const Value &elem) {
+        const Value result = call(stream, elem);
+        if (!std::holds_alternative<double>(result)) {
+            options_v.logger.error({}, "runtime error: stream predicate returned ", result, ", expected <Float>");
+        }
+        return std::get<double>(result) != 0;
+    }
+
+    static Cursor open(const std::string &name, const Value &source) {
+        if (const auto *list = std::get_if<std::shared_ptr<List> >(&source)) {
+            if ((*list)->numeric) {
+                return [list = *list, it = (*list)->floats.begin()]() mutable -> std::optional<Value> {
+                    if (it == list->floats.end()) return std::nullopt;
+                    return Value{*it++};
+                };
+            }
+            return [list = *list, it = (*list)->elements.begin()]() mutable -> std::optional<Value> {
+                if (it == list->elements.end()) return std::nullopt;
+                return *it++;
+            };
+        }
+        if (!std::holds_alternative<std::shared_ptr<Stream> >(source)) {
+            options_v.logger.error({}, "runtime error: native function ", name, " expects a List or Stream, got ",
+                                   source);
+        }
+        auto stream = std::get<std::shared_ptr<Stream> >(source);
+        switch (stream->kind) {
+            case Stream::Kind::Range:
+                // Elements are start + i rather than a running sum, so long ranges do not drift
+                return [stream, i = 0.0]() mutable -> std::optional<Value> {
+                    const double value = stream->start + i;
+                    if (value >= stream->end) return std::nullopt;
+                    ++i;
+                    return Value{value};
+                };
+            case Stream::Kind::Iterate:
+                return [stream, current = std::optional<Value>{}]() mutable -> std::optional<Value> {
+                    current = current ? call(*stream, *current) : stream->source;
+                    return current;
+                };
+            case Stream::Kind::Take:
+                return [stream, inner = open(name, stream->source), left = stream->end]() mutable
+                    -> std::optional<Value> {
+                    if (left < 1) return std::nullopt;
+                    --left;
+                    return inner();
+                };
+            case Stream::Kind::Filter:
+                return [stream, inner = open(name, stream->source)]() mutable -> std::optional<Value> {
+                    for (auto elem = inner(); elem; elem = inner()) {
+                        if (holds(*stream, *elem)) return elem;
+                    }
+                    return std::nullopt;
+                };
+            case Stream::Kind::Map:
+                return [stream, inner = open(name, stream->source)]() mutable -> std::optional<Value> {
+                    auto elem = inner();
+                    if (!elem) return std::nullopt;
+                    return call(*stream, std::move(*elem));
+                };
+            case Stream::Kind::DropWhile:
+                return [stream, inner = open(name, stream->source), dropping = true]() mutable
+                    -> std::optional<Value> {
+                    auto elem = inner();
+                    while (dropping && elem && holds(*stream, *elem)) {
+                        elem = inner();
+                    }
+                    dropping = false;
+                    return elem;
+                };
+            case Stream::Kind::Zip: {
+                std::vector<std::shared_ptr<List> > rows;
+                size_t min_size = SIZE_MAX;
+                std::get<std::shared_ptr<List> >(stream->source)->for_each([&](const Value &elem) {
+                    if (!std::holds_alternative<std::shared_ptr<List> >(elem)) {
+                        options_v.logger.error({}, "runtime error: native function zip expects List of List, but got "
+                                               "element ", elem);
+                    }
+                    rows.push_back(std::get<std::shared_ptr<List> >(elem));
+                    min_size = std::min(min_size, rows.back()->size());
+                });
+                return [rows = std::move(rows), min_size, i = size_t{0}]() mutable -> std::optional<Value> {
+                    if (rows.empty() || i == min_size) return std::nullopt;
+                    std::vector<Value> tuple;
+                    tuple.reserve(rows.size());
+                    for (const auto &row: rows) {
+                        tuple.push_back(row->at(i));
+                    }
+                    ++i;
+                    return Value{std::make_shared<List>(std::move(tuple))};
+                };
+            }
+        }
+        UNREACHABLE("unhandled stream kind");
+    }
+
+    // Argument Thunk of the unevaluated application that would have produced this one's value
+    static std::shared_ptr<Thunk> inner_arg(const Thunk &outer, const fe::ast::ExprId expr) {
+        auto thunk = std::make_shared<Thunk>();
+        if (outer.owned) {
+            thunk->set_owned(outer.owned, expr, outer.env);
+        } else {
+            thunk->set(outer.arena, expr, outer.env);
+        }
+        return thunk;
+    }
+
+    // The builtin name resolves to where the application is evaluated, unless the name was rebound
+    static std::shared_ptr<NativeFunction> builtin(const Env &env, const std::string &name) {
+        const auto thunk = env.lookup(name);
+        if (!thunk) return nullptr;
+        const auto *native_fn = std::get_if<std::shared_ptr<NativeFunction> >(&thunk->force());
+        return native_fn && (*native_fn)->name == name ? *native_fn : nullptr;
+    }
+
+    Value fused_source(const std::shared_ptr<Thunk> &arg) {
+        if (arg->cached || !arg->arena || !arg->env) {
+            return arg->force();
+        }
+        const auto *fn_apl = std::get_if<fe::ast::FunctionApplication>(&(*arg->arena)[arg->expr].value);
+        // A fused map applies f while the consumer runs, so their side effects interleave per element
+        const bool fusable = fn_apl && (fn_apl->fn_name.value == "zip" ||
+                                        (fn_apl->fn_name.value == "map" && options_v.fuse_maps));
+        if (!fusable) {
+            return arg->force();
+        }
+        const std::string &callee = fn_apl->fn_name.value;
+        const auto args = arg->arena->args_of(*fn_apl);
+        const auto native_fn = builtin(*arg->env, callee);
+        if (!native_fn || args.size() != static_cast<size_t>(native_fn->arity)) {
+            return arg->force();
+        }
+        std::vector<std::shared_ptr<Thunk> > arg_thunks;
+        for (const fe::ast::ExprId expr: args) {
+            arg_thunks.push_back(inner_arg(*arg, expr));
+        }
+        // Same order as the builtins force their arguments
+        const Value fn_val = callee == "map" ? arg_thunks[0]->force() : Value{};
+        Value source = callee == "map" ? fused_source(arg_thunks[1]) : arg_thunks[0]->force();
+        if (callee == "map" && (std::holds_alternative<std::shared_ptr<List> >(source) ||
+                                std::holds_alternative<std::shared_ptr<Stream> >(source))) {
+            return Value{
+                std::make_shared<Stream>(Stream{Stream::Kind::Map, 0, 0, fn_val, std::move(source), arg->env})
+            };
+        }
+        if (callee == "zip" && std::holds_alternative<std::shared_ptr<List> >(source)) {
+            return Value{std::make_shared<Stream>(Stream{Stream::Kind::Zip, 0, 0, {}, std::move(source), nullptr})};
+        }
+        // Not fusable, the builtin reports its own error without evaluating the source again
+        arg_thunks.back() = std::make_shared<Thunk>();
+        arg_thunks.back()->cached = std::move(source);
+        return apply_fn_apl(Value{native_fn}, arg_thunks, arg->env, fn_apl->loc, callee);
+    }
+
+    void for_each_element(const std::string &name, const Value &source, const std::function<bool(const Value &)> &fn) {
+        const Cursor next = open(name, source);
+        for (auto elem = next(); elem; elem = next()) {
+            if (!fn(*elem)) return;
+        }
+    }
+
+    static void check_source(const std::string &name, const char *signature, const Value &source) {
+        if (!std::holds_alternative<std::shared_ptr<List> >(source) &&
+            !std::holds_alternative<std::shared_ptr<Stream> >(source)) {
+            options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                   "\n", name, " signature: ", signature, "\n"
+                                   "runtime error: expected <List> or <Stream> got ", source);
+        }
+    }
+
+    // Stream of kind over source, applying fn in the caller's Environment
+    static NativeFunction make_stage(const std::string &name, const Stream::Kind kind, const char *signature) {
+        return {
+            2, name, [name, kind, signature](const std::vector<std::shared_ptr<Thunk> > &args,
+                                             const std::shared_ptr<Env> &call_site_env)
+                -> std::pair<Value, ResultOptions> {
+                const Value source = fused_source(args[1]);
+                check_source(name, signature, source);
+                auto stream = std::make_shared<Stream>(Stream{kind, 0, 0, args[0]->force(), source, call_site_env});
+                return {Value{std::move(stream)}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_range() {
+        const std::string name = "range";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value &value1 = args[0]->force();
+                const Value &value2 = args[1]->force();
+                if (!std::holds_alternative<double>(value1) || !std::holds_alternative<double>(value2)) {
+                    options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                           "\n", name, " signature: Float -> Float -> Stream");
+                }
+                auto stream = std::make_shared<Stream>(
+                    Stream{Stream::Kind::Range, std::get<double>(value1), std::get<double>(value2), {}, {}, nullptr});
+                return {Value{std::move(stream)}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_iterate() {
+        const std::string name = "iterate";
+        return {
+            2, name, [](const std::vector<std::shared_ptr<Thunk> > &args,
+                        const std::shared_ptr<Env> &call_site_env) -> std::pair<Value, ResultOptions> {
+                auto stream = std::make_shared<Stream>(
+                    Stream{Stream::Kind::Iterate, 0, 0, args[0]->force(), args[1]->force(), call_site_env});
+                return {Value{std::move(stream)}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_take() {
+        const std::string name = "take";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value &count = args[0]->force();
+                if (!std::holds_alternative<double>(count)) {
+                    options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                           "\n", name, " signature: Float -> Stream -> Stream\n"
+                                           "runtime error: expected <Float> got ", count);
+                }
+                const Value source = fused_source(args[1]);
+                check_source(name, "Float -> Stream -> Stream", source);
+                auto stream = std::make_shared<Stream>(
+                    Stream{Stream::Kind::Take, 0, std::get<double>(count), {}, source, nullptr});
+                return {Value{std::move(stream)}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_filter() {
+        return make_stage("filter", Stream::Kind::Filter, "(A -> Float) -> Stream<A> -> Stream<A>");
+    }
+
+    NativeFunction make_drop_while() {
+        return make_stage("drop_while", Stream::Kind::DropWhile, "(A -> Float) -> Stream<A> -> Stream<A>");
+    }
+
+    NativeFunction make_map_lazy() {
+        return make_stage("map_lazy", Stream::Kind::Map, "(A -> B) -> Stream<A> -> Stream<B>");
+    }
+
+    NativeFunction make_to_list() {
+        const std::string name = "to_list";
+        return {
+            1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value source = fused_source(args[0]);
+                check_source(name, "Stream<A> -> List<A>", source);
+                if (std::holds_alternative<std::shared_ptr<List> >(source)) {
+                    return {source, ResultOptions{}};
+                }
+                std::vector<Value> values;
+                for_each_element(name, source, [&](const Value &elem) {
+                    values.push_back(elem);
+                    return true;
+                });
+                return {Value{std::make_shared<List>(std::move(values))}, ResultOptions{}};
+            }
+        };
+    }
+
+    // Every step forces the accumulator, which is what foldl' names elsewhere
+    static NativeFunction make_left_fold(const std::string &name) {
+        return {
+            3, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &call_site_env) -> std::pair<Value, ResultOptions> {
+                RepeatedCall step(args[0]->force(), call_site_env, 2);
+                const Value source = fused_source(args[2]);
+                check_source(name, "(B -> A -> B) -> B -> Stream<A> -> B", source);
+                std::array<Value, 2> step_args{args[1]->force(), Value{}};
+                for_each_element(name, source, [&](const Value &elem) {
+                    // fn takes (accumulator, element)
+                    step_args[1] = elem;
+                    step_args[0] = step(step_args);
+                    return true;
+                });
+                return {std::move(step_args[0]), ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_foldl() {
+        return make_left_fold("foldl");
+    }
+
+    NativeFunction make_foldl_strict() {
+        return make_left_fold("foldl'");
+    }
+
+    NativeFunction make_fold_until() {
+        const std::string name = "fold_until";
+        return {
+            4, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &call_site_env) -> std::pair<Value, ResultOptions> {
+                RepeatedCall stop(args[0]->force(), call_site_env, 1);
+                RepeatedCall step(args[1]->force(), call_site_env, 2);
+                const Value source = fused_source(args[3]);
+                check_source(name, "(B -> Float) -> (B -> A -> B) -> B -> Stream<A> -> B", source);
+                std::array<Value, 2> step_args{args[2]->force(), Value{}};
+                std::array<Value, 1> stop_args;
+                // The accumulator is tested before every element, so no element past the stop is read
+                const auto stopped = [&] {
+                    stop_args[0] = step_args[0];
+                    const Value done = stop(stop_args);
+                    if (!std::holds_alternative<double>(done)) {
+                        options_v.logger.error({}, "runtime error: fold_until predicate returned ", done,
+                                               ", expected <Float>");
+                    }
+                    return std::get<double>(done) != 0;
+                };
+                if (!stopped()) {
+                    for_each_element(name, source, [&](const Value &elem) {
+                        step_args[1] = elem;
+                        step_args[0] = step(step_args);
+                        return !stopped();
+                    });
+                }
+                return {std::move(step_args[0]), ResultOptions{}};
+            }
+        };
+    }
+}
@@ -0,0 +1,100 @@
+#include <charconv>
+#include <lbd/intp/builtin-modules/builtin_module_stream.h>
+#include <lbd/intp/builtin-modules/builtin_module_string.h>
+
+namespace intp::interp::builtins {
+    static const std::string &text_arg(const std::string &name, const char *signature, const Value &value) {
+        const std::string *text = text_of(value);
+        if (!text) {
+            options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                   "\n", name, " signature: ", signature, "\n"
+                                   "runtime error: expected <String> got ", value);
+        }
+        return *text;
+    }
+
+    NativeFunction make_join() {
+        const std::string name = "join";
+        return {
+            2, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const char *signature = "String -> List<String> -> String";
+                const std::string &sep = text_arg(name, signature, args[0]->force());
+                const Value source = fused_source(args[1]);
+                std::string result;
+                bool first = true;
+                for_each_element(name, source, [&](const Value &elem) {
+                    if (!first) {
+                        result += sep;
+                    }
+                    first = false;
+                    // A Rope element is appended leaf by leaf instead of being flattened
+                    if (const auto *rope = std::get_if<std::shared_ptr<Rope> >(&elem)) {
+                        (*rope)->for_each_chunk([&](const std::string_view chunk) {
+                            result.append(chunk);
+                        });
+                    } else {
+                        result += text_arg(name, signature, elem);
+                    }
+                    return true;
+                });
+                return {Value{std::move(result)}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_str_len() {
+        const std::string name = "str_len";
+        return {
+            1, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value &arg0 = args[0]->force();
+                // A Rope knows its length without being flattened
+                if (const auto *rope = std::get_if<std::shared_ptr<Rope> >(&arg0)) {
+                    return {Value{static_cast<double>((*rope)->length)}, ResultOptions{}};
+                }
+                const std::string &text = text_arg(name, "String -> Float", arg0);
+                return {Value{static_cast<double>(text.size())}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_substr() {
+        const std::string name = "substr";
+        return {
+            3, name, [name](const std::vector<std::shared_ptr<Thunk> > &args,
+                            const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const char *signature = "String -> Float -> Float -> String";
+                const std::string &text = text_arg(name, signature, args[0]->force());
+                const size_t start = index_arg(name, signature, args[1]->force());
+                const size_t length = index_arg(name, signature, args[2]->force());
+                if (start > text.size()) {
+                    options_v.logger.error({}, "runtime error: substring start ", start, " is past the end of a ",
+                                           text.size(), " byte string");
+                }
+                // The length is clamped to the end of the string
+                return {Value{text.substr(start, std::min(length, text.size() - start))}, ResultOptions{}};
+            }
+        };
+    }
+
+    NativeFunction make_to_string() {
+        const std::string name = "to_string";
+        return {
+            1, name, [](const std::vector<std::shared_ptr<Thunk> > &args,
+                        const std::shared_ptr<Env> &) -> std::pair<Value, ResultOptions> {
+                const Value &arg0 = args[0]->force();
+                if (const auto *number = std::get_if<double>(&arg0)) {
+                    char buffer[32];
+                    const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), *number);
+                    return {Value{std::string(buffer, end)}, ResultOptions{}};
+                }
+                // Texts are returned as they are, a Rope stays unflattened
+                if (std::holds_alternative<std::string>(arg0) || std::holds_alternative<std::shared_ptr<Rope> >(arg0)) {
+                    return {arg0, ResultOptions{}};
+                }
+                return {Value{arg0.to_string()}, ResultOptions{}};
+            }
+        };
+    }
+}
@@ -1,13 +1,41 @@
+#include <cmath>
+#include <limits>
 #include <lbd/intp/builtins.h>
 #include <lbd/intp/builtin-modules/builtin_module_core.h>
+#include <lbd/intp/builtin-modules/builtin_module_dict.h>
 #include <lbd/intp/builtin-modules/builtin_module_list.h>
 #include <lbd/intp/builtin-modules/builtin_module_io.h>
+#include <lbd/intp/builtin-modules/builtin_module_numeric.h>
+#include <lbd/intp/builtin-modules/builtin_module_stream.h>
+#include <lbd/intp/builtin-modules/builtin_module_string.h>
 
 // TODO: Add module system like use module io. Which dlopen's the module and loads it.
 
 namespace intp::interp::builtins {
     options::Options options_v;
 
+    const std::string *text_of(const Value &value) {
+        if (const auto *str = std::get_if<std::string>(&value)) {
+            return str;
+        }
+        if (const auto *rope = std::get_if<std::shared_ptr<Rope> >(&value)) {
+            return &(*rope)->flat();
+        }
+        return nullptr;
+    }
+
+    size_t index_arg(const std::string &name, const char *signature, const Value &value) {
+        // Casting a negative, fractional or non-finite double to size_t is undefined, so those never reach it
+        const auto *number = std::get_if<double>(&value);
+        if (!number || !std::isfinite(*number) || *number < 0 || std::trunc(*number) != *number ||
+            *number >= static_cast<double>(std::numeric_limits<size_t>::max())) {
+            options_v.logger.error({}, "runtime error: wrong arguments provided to native function ", name,
+                                   "\n", name, " signature: ", signature, "\n"
+                                   "runtime error: expected a non-negative whole <Float> got ", value);
+        }
+        return static_cast<size_t>(*number);
+    }
+
     std::vector<NativeFunction> get_builtins(const options::Options options_) {
         options_v = options_;
         return {
@@ -27,8 +55,55 @@ namespace intp::interp::builtins {
             {make_map()},
             {make_transpose()},
             {make_sort()},
+            {make_sort_by()},
+            {make_sort_with()},
             {make_zip()},
             {make_foldr()},
+            {make_push()},
+            {make_set()},
+            {make_concat()},
+            {make_slice()},
+            {make_bsearch()},
+            {make_lower_bound()},
+            {make_upper_bound()},
+            {make_unique()},
+            {make_intersect()},
+            {make_union()},
+            {make_difference()},
+            // Numeric module
+            {make_sum()},
+            {make_product()},
+            {make_min()},
+            {make_max()},
+            {make_mean()},
+            {make_dot()},
+            {make_vadd()},
+            {make_vsub()},
+            {make_vmul()},
+            {make_vscale()},
+            // Stream module
+            {make_range()},
+            {make_iterate()},
+            {make_take()},
+            {make_filter()},
+            {make_drop_while()},
+            {make_map_lazy()},
+            {make_to_list()},
+            {make_foldl()},
+            {make_foldl_strict()},
+            {make_fold_until()},
+            // Dict module
+            {make_dict()},
+            {make_dict_get()},
+            {make_dict_put()},
+            {make_dict_keys()},
+            {make_frequencies()},
+            {make_group_by()},
+            // String module
+            {make_join()},
+            {make_str_len()},
+            {make_substr()},
+            {make_to_string()},
             // IO module
             {make_slurp_file()},
             {make_lines()},
@@ -0,0 +1,86 @@
+#include <unordered_set>
+#include <vector>
+#include <lbd/intp/cow.h>
+#include <lbd/intp/interpreter.h>
+
+namespace intp::cow {
+    /// Original contents of every frozen List changed since the last thaw
+    static std::vector<std::pair<std::shared_ptr<interp::List>, interp::List> > saved;
+    static std::unordered_set<const interp::List *> saved_lists;
+    /// Frozen Thunks computed after a frozen List was changed
+    static std::vector<std::weak_ptr<const interp::Thunk> > tainted;
+
+    // Frozen Envs and Lists are not entered again, so freezing what a Thunk computed only walks the new part
+    static void freeze_reachable(std::vector<std::shared_ptr<interp::Env> > envs, std::vector<interp::Value> values) {
+        while (!envs.empty() || !values.empty()) {
+            if (!envs.empty()) {
+                const auto env = std::move(envs.back());
+                envs.pop_back();
+                if (!env || env->frozen) continue;
+                env->frozen = true;
+                for (const auto &[_, thunk]: env->table) {
+                    if (thunk->frozen) continue;
+                    thunk->frozen = true;
+                    if (thunk->cached) {
+                        values.push_back(*thunk->cached);
+                    } else {
+                        envs.push_back(thunk->env);
+                    }
+                }
+                envs.push_back(env->parent);
+                continue;
+            }
+            const auto value = std::move(values.back());
+            values.pop_back();
+            if (const auto *list = std::get_if<std::shared_ptr<interp::List> >(&value)) {
+                if ((*list)->frozen) continue;
+                (*list)->frozen = true;
+                for (const auto &element: (*list)->elements) {
+                    values.push_back(element);
+                }
+            } else if (const auto *closure = std::get_if<interp::Closure>(&value)) {
+                envs.push_back(closure->env);
+            } else if (const auto *stream = std::get_if<std::shared_ptr<interp::Stream> >(&value)) {
+                values.push_back((*stream)->fn);
+                values.push_back((*stream)->source);
+                envs.push_back((*stream)->env);
+            } else if (const auto *dict = std::get_if<std::shared_ptr<interp::Dict> >(&value)) {
+                (*dict)->entries.for_each([&](const interp::Value &, const interp::Value &elem) {
+                    values.push_back(elem);
+                });
+            }
+        }
+    }
+
+    void freeze(const std::shared_ptr<interp::Env> &root) {
+        freeze_reachable({root}, {});
+    }
+
+    void before_write(const std::shared_ptr<interp::List> &list) {
+        if (saved_lists.insert(list.get()).second) {
+            saved.emplace_back(list, *list);
+        }
+    }
+
+    void on_computed(const interp::Thunk &thunk) {
+        if (saved.empty()) {
+            freeze_reachable({}, {*thunk.cached});
+        } else {
+            tainted.push_back(thunk.weak_from_this());
+        }
+    }
+
+    void thaw() {
+        for (const auto &[list, contents]: saved) {
+            *list = contents;
+        }
+        saved.clear();
+        saved_lists.clear();
+        for (const auto &weak: tainted) {
+            if (const auto thunk = weak.lock()) {
+                thunk->cached.reset();
+            }
+        }
+        tainted.clear();
+    }
+}
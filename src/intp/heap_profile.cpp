@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <lbd/intp/heap_profile.h>
+#include <lbd/intp/interpreter.h>
+
+namespace intp::heap {
+    struct Entry {
+        Kind kind;
+        std::optional<fe::loc::Loc> loc;
+    };
+
+    static std::unordered_map<const void *, Entry> live;
+    static std::map<std::pair<uint32_t, uint32_t>, uint64_t> closures; /// Creations by (file id, offset)
+    static thread_local std::optional<fe::loc::Loc> current_site_v;
+
+    static constexpr const char *KIND_NAMES[] = {"thunk", "env", "list"};
+    static constexpr size_t KINDS = std::size(KIND_NAMES);
+
+    /// Reference count and allocation header of std::make_shared
+    static constexpr size_t CONTROL_BLOCK = 16;
+
+    void start() {
+        live.clear();
+        closures.clear();
+        enabled = true;
+    }
+
+    void stop() {
+        enabled = false;
+    }
+
+    void track(const void *object, const Kind kind, const std::optional<fe::loc::Loc> &loc) {
+        live[object] = {kind, loc};
+    }
+
+    void untrack(const void *object) {
+        live.erase(object);
+    }
+
+    void count_closure(const fe::loc::Loc &loc) {
+        ++closures[{loc.file_id, loc.offset}];
+    }
+
+    const std::optional<fe::loc::Loc> &current_site() {
+        return current_site_v;
+    }
+
+    void set_current_site(const std::optional<fe::loc::Loc> &loc) {
+        current_site_v = loc;
+    }
+
+    // Heap payload of a string beyond the small string buffer
+    static size_t string_bytes(const std::string &value) {
+        return value.capacity() > 15 ? value.capacity() + 1 : 0;
+    }
+
+    static size_t value_bytes(const interp::Value &value) {
+        if (const auto *str = std::get_if<std::string>(&value)) {
+            return string_bytes(*str);
+        }
+        // Leaves are counted by their text, the nodes above them are left out
+        if (const auto *rope = std::get_if<std::shared_ptr<interp::Rope> >(&value)) {
+            return (*rope)->length;
+        }
+        return 0;
+    }
+
+    static size_t shallow_bytes(const interp::Thunk &thunk) {
+        size_t bytes = sizeof(interp::Thunk) + CONTROL_BLOCK + thunk.dependents.size() * 48;
+        if (thunk.cached) {
+            bytes += value_bytes(*thunk.cached);
+        }
+        return bytes;
+    }
+
+    static size_t shallow_bytes(const interp::Env &env) {
+        size_t bytes = sizeof(interp::Env) + CONTROL_BLOCK + env.table.bucket_count() * sizeof(void *);
+        for (const auto &[name, _]: env.table) {
+            bytes += sizeof(std::pair<const std::string, std::shared_ptr<interp::Thunk> >) + sizeof(void *) * 2 +
+                    string_bytes(name);
+        }
+        return bytes;
+    }
+
+    static size_t shallow_bytes(const interp::List &list) {
+        // Chunks shared between versions of a list are counted for each of them
+        size_t bytes = sizeof(interp::List) + CONTROL_BLOCK + list.floats.size() * sizeof(double) +
+                       list.elements.size() * sizeof(interp::Value);
+        for (const auto &element: list.elements) {
+            bytes += value_bytes(element);
+        }
+        return bytes;
+    }
+
+    static size_t entry_bytes(const void *object, const Kind kind) {
+        switch (kind) {
+            case Kind::Thunk:
+                return shallow_bytes(*static_cast<const interp::Thunk *>(object));
+            case Kind::Env:
+                return shallow_bytes(*static_cast<const interp::Env *>(object));
+            case Kind::List:
+                return shallow_bytes(*static_cast<const interp::List *>(object));
+        }
+        return 0;
+    }
+
+    static std::string site_label(const std::optional<fe::loc::Loc> &loc) {
+        if (!loc) {
+            return "<toplevel>";
+        }
+        std::ostringstream oss;
+        oss << *loc;
+        return oss.str();
+    }
+
+    struct SiteTotals {
+        std::string site;
+        uint64_t count[KINDS] = {};
+        uint64_t bytes[KINDS] = {};
+
+        [[nodiscard]] uint64_t total_bytes() const {
+            return bytes[0] + bytes[1] + bytes[2];
+        }
+    };
+
+    static std::vector<SiteTotals> collect() {
+        std::map<std::string, SiteTotals> by_site;
+        for (const auto &[object, entry]: live) {
+            auto &totals = by_site[site_label(entry.loc)];
+            const auto k = static_cast<size_t>(entry.kind);
+            ++totals.count[k];
+            totals.bytes[k] += entry_bytes(object, entry.kind);
+        }
+        std::vector<SiteTotals> sites;
+        sites.reserve(by_site.size());
+        for (auto &[site, totals]: by_site) {
+            totals.site = site;
+            sites.push_back(std::move(totals));
+        }
+        return sites;
+    }
+
+    /// Closures created per lambda sorted by site, including those no longer referenced
+    static std::vector<std::pair<std::string, uint64_t> > collect_closures() {
+        std::map<std::string, uint64_t> by_site;
+        for (const auto &[key, count]: closures) {
+            by_site[site_label(fe::loc::Loc{key.first, key.second})] += count;
+        }
+        return {by_site.begin(), by_site.end()};
+    }
+
+    /// Bytes of the Thunks, Envs and Lists reachable from thunk without passing through the global Env
+    static uint64_t reachable_bytes(const interp::Thunk &root, const interp::Env *global_env) {
+        std::unordered_set<const void *> visited;
+        std::vector<const interp::Thunk *> thunks{&root};
+        std::vector<const interp::Env *> envs;
+        std::vector<const interp::Value *> values;
+        uint64_t bytes = 0;
+        while (!thunks.empty() || !envs.empty() || !values.empty()) {
+            if (!thunks.empty()) {
+                const interp::Thunk *thunk = thunks.back();
+                thunks.pop_back();
+                if (!visited.insert(thunk).second) continue;
+                bytes += shallow_bytes(*thunk);
+                if (thunk->cached) {
+                    values.push_back(&*thunk->cached);
+                } else if (thunk->env) {
+                    // An unevaluated Thunk keeps its whole Environment alive
+                    envs.push_back(thunk->env.get());
+                }
+            } else if (!envs.empty()) {
+                const interp::Env *env = envs.back();
+                envs.pop_back();
+                if (env == global_env || !visited.insert(env).second) continue;
+                bytes += shallow_bytes(*env);
+                for (const auto &[_, thunk]: env->table) {
+                    thunks.push_back(thunk.get());
+                }
+                if (env->parent) {
+                    envs.push_back(env->parent.get());
+                }
+            } else {
+                const interp::Value *value = values.back();
+                values.pop_back();
+                if (const auto *list = std::get_if<std::shared_ptr<interp::List> >(value)) {
+                    if (!visited.insert(list->get()).second) continue;
+                    bytes += shallow_bytes(**list);
+                    for (const auto &element: (*list)->elements) {
+                        values.push_back(&element);
+                    }
+                } else if (const auto *closure = std::get_if<interp::Closure>(value)) {
+                    envs.push_back(closure->env.get());
+                } else if (const auto *stream = std::get_if<std::shared_ptr<interp::Stream> >(value)) {
+                    values.push_back(&(*stream)->fn);
+                    values.push_back(&(*stream)->source);
+                    if ((*stream)->env) {
+                        envs.push_back((*stream)->env.get());
+                    }
+                } else if (const auto *dict = std::get_if<std::shared_ptr<interp::Dict> >(value)) {
+                    if (!visited.insert(dict->get()).second) continue;
+                    (*dict)->entries.for_each([&](const interp::Value &, const interp::Value &elem) {
+                        values.push_back(&elem);
+                    });
+                }
+            }
+        }
+        return bytes;
+    }
+
+    void report(std::ostream &os, const std::shared_ptr<interp::Env> &global_env, const size_t limit) {
+        auto sites = collect();
+        std::stable_sort(sites.begin(), sites.end(), [](const SiteTotals &a, const SiteTotals &b) {
+            return a.total_bytes() > b.total_bytes();
+        });
+        if (limit != 0 && sites.size() > limit) {
+            sites.resize(limit);
+        }
+        os << std::right << std::setw(12) << "live bytes" << std::setw(10) << "thunks" << std::setw(10) << "envs"
+                << std::setw(10) << "lists" << "  site" << std::endl;
+        for (const auto &s: sites) {
+            os << std::setw(12) << s.total_bytes() << std::setw(10) << s.count[0] << std::setw(10) << s.count[1]
+                    << std::setw(10) << s.count[2] << "  " << s.site << std::endl;
+        }
+        auto created = collect_closures();
+        if (!created.empty()) {
+            std::stable_sort(created.begin(), created.end(), [](const auto &a, const auto &b) {
+                return a.second > b.second;
+            });
+            if (limit != 0 && created.size() > limit) {
+                created.resize(limit);
+            }
+            os << std::endl << std::setw(12) << "closures" << "  site (created, live or not)" << std::endl;
+            for (const auto &[site, count]: created) {
+                os << std::setw(12) << count << "  " << site << std::endl;
+            }
+        }
+        if (!global_env) {
+            return;
+        }
+        std::vector<std::pair<uint64_t, std::string> > bindings;
+        for (const auto &[name, thunk]: global_env->table) {
+            if (thunk) {
+                bindings.emplace_back(reachable_bytes(*thunk, global_env.get()), name);
+            }
+        }
+        std::sort(bindings.begin(), bindings.end(), [](const auto &a, const auto &b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        if (limit != 0 && bindings.size() > limit) {
+            bindings.resize(limit);
+        }
+        os << std::endl << std::setw(12) << "reachable" << "  global binding" << std::endl;
+        for (const auto &[bytes, name]: bindings) {
+            os << std::setw(12) << bytes << "  " << name << std::endl;
+        }
+    }
+
+    void write(std::ostream &os) {
+        os << "# site\tkind\tcount\tbytes\n";
+        for (const auto &s: collect()) {
+            for (size_t k = 0; k < KINDS; ++k) {
+                if (s.count[k] != 0) {
+                    os << s.site << '\t' << KIND_NAMES[k] << '\t' << s.count[k] << '\t' << s.bytes[k] << '\n';
+                }
+            }
+        }
+        os << "# site\tclosures-created\n";
+        for (const auto &[site, count]: collect_closures()) {
+            os << site << '\t' << count << '\n';
+        }
+    }
+}
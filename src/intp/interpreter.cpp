@@ -1,7 +1,15 @@
 #include <lbd/intp/interpreter.h>
 #include <lbd/intp/builtins.h>
+#include <lbd/fe/trace.h>
+#include <lbd/intp/cow.h>
+#include <lbd/intp/heap_profile.h>
+#include <lbd/intp/profiler.h>
+#include <lbd/intp/stats.h>
 #include <lbd/options.h>
 #include <lbd/error.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <sstream>
 
 #include "lbd/utils/string_escape.h"
@@ -20,15 +28,133 @@ namespace intp::interp {
         return os << closure.to_string();
     }
 
+    List::List() {
+        heap::on_create(this, heap::Kind::List);
+    }
+
+    List::List(PVector<Value> elements) : elements(std::move(elements)), numeric(false) {
+        heap::on_create(this, heap::Kind::List);
+    }
+
+    List::List(PVector<double> floats) : floats(std::move(floats)) {
+        heap::on_create(this, heap::Kind::List);
+    }
+
+    List::List(std::vector<Value> elements) {
+        heap::on_create(this, heap::Kind::List);
+        if (!std::ranges::all_of(elements, [](const Value &v) { return std::holds_alternative<double>(v); })) {
+            this->elements = PVector(std::move(elements));
+            numeric = false;
+            return;
+        }
+        std::vector<double> values;
+        values.reserve(elements.size());
+        for (const auto &element: elements) {
+            values.push_back(std::get<double>(element));
+        }
+        floats = PVector(std::move(values));
+    }
+
+    List::List(std::vector<double> floats) : floats(std::move(floats)) {
+        heap::on_create(this, heap::Kind::List);
+    }
+
+    List::List(const List &other) : elements(other.elements), floats(other.floats), numeric(other.numeric) {
+        heap::on_create(this, heap::Kind::List);
+    }
+
+    List::List(List &&other) noexcept
+        : elements(std::move(other.elements)), floats(std::move(other.floats)), numeric(other.numeric) {
+        heap::on_create(this, heap::Kind::List);
+    }
+
+    List &List::operator=(const List &other) {
+        elements = other.elements;
+        floats = other.floats;
+        numeric = other.numeric;
+        return *this;
+    }
+
+    List &List::operator=(List &&other) noexcept {
+        elements = std::move(other.elements);
+        floats = std::move(other.floats);
+        numeric = other.numeric;
+        return *this;
+    }
+
+    List::~List() {
+        heap::on_destroy(this);
+    }
+
+    size_t List::size() const {
+        return numeric ? floats.size() : elements.size();
+    }
+
+    bool List::empty() const {
+        return size() == 0;
+    }
+
+    Value List::at(const size_t index) const {
+        return numeric ? Value{floats[index]} : elements[index];
+    }
+
+    PVector<Value> List::boxed() const {
+        if (!numeric) {
+            return elements;
+        }
+        std::vector<Value> values;
+        values.reserve(floats.size());
+        floats.for_each_chunk([&](const std::span<const double> chunk) {
+            values.insert(values.end(), chunk.begin(), chunk.end());
+        });
+        return PVector(std::move(values));
+    }
+
+    List List::push_back(Value value) const {
+        if (!numeric) {
+            return List(elements.push_back(std::move(value)));
+        }
+        if (const auto *number = std::get_if<double>(&value)) {
+            return List(floats.push_back(*number));
+        }
+        return List(boxed().push_back(std::move(value)));
+    }
+
+    List List::set(const size_t index, Value value) const {
+        if (!numeric) {
+            return List(elements.set(index, std::move(value)));
+        }
+        if (const auto *number = std::get_if<double>(&value)) {
+            return List(floats.set(index, *number));
+        }
+        return List(boxed().set(index, std::move(value)));
+    }
+
+    List List::erase(const size_t index) const {
+        return numeric ? List(floats.erase(index)) : List(elements.erase(index));
+    }
+
+    List List::slice(const size_t begin, const size_t end) const {
+        return numeric ? List(floats.slice(begin, end)) : List(elements.slice(begin, end));
+    }
+
+    List List::concat(const List &a, const List &b) {
+        if (a.numeric && b.numeric) {
+            return List(PVector<double>::concat(a.floats, b.floats));
+        }
+        return List(PVector<Value>::concat(a.boxed(), b.boxed()));
+    }
+
     [[nodiscard]] std::string List::to_string() const {
         std::ostringstream oss;
         oss << "[";
-        for (size_t i = 0; i < elements.size(); ++i) {
-            oss << escape(elements[i].to_string());
-            if (i + 1 != elements.size()) {
+        size_t i = 0;
+        for_each([&](const Value &element) {
+            oss << escape(element.to_string());
+            if (++i != size()) {
                 oss << ", ";
             }
-        }
+        });
         oss << "]";
         return oss.str();
     }
@@ -43,7 +169,10 @@ namespace intp::interp {
             } else if constexpr (std::is_same_v<T, Closure>) {
                 return arg.to_string();
             } else if constexpr (std::is_same_v<T, std::shared_ptr<NativeFunction> > ||
-                                 std::is_same_v<T, std::shared_ptr<List> >) {
+                                 std::is_same_v<T, std::shared_ptr<List> > ||
+                                 std::is_same_v<T, std::shared_ptr<Stream> > ||
+                                 std::is_same_v<T, std::shared_ptr<Dict> > ||
+                                 std::is_same_v<T, std::shared_ptr<Rope> >) {
                 return arg->to_string();
             } else {
                 STATIC_ASSERT_UNREACHABLE_T(T, "unhandled runtime value");
@@ -52,6 +181,10 @@ namespace intp::interp {
     }
 
     std::ostream &operator<<(std::ostream &os, const Value &value) {
+        // Ropes are written leaf by leaf rather than flattened first
+        if (const auto *rope = std::get_if<std::shared_ptr<Rope> >(&value)) {
+            return os << **rope;
+        }
         return os << value.to_string();
     }
 
@@ -63,6 +196,127 @@ namespace intp::interp {
         return os << list.to_string();
     }
 
+    [[nodiscard]] std::string Stream::to_string() const {
+        static constexpr const char *KIND_NAMES[] = {"range", "iterate", "take", "filter", "map_lazy", "drop_while", "zip"};
+        return std::string("<stream: ") + KIND_NAMES[static_cast<size_t>(kind)] + ">";
+    }
+
+    std::ostream &operator<<(std::ostream &os, const Stream &stream) {
+        return os << stream.to_string();
+    }
+
+    Rope::Rope(std::string text) : length(text.size()), text(std::move(text)) {
+    }
+
+    Rope::Rope(std::shared_ptr<Rope> left, std::shared_ptr<Rope> right)
+        : length(left->length + right->length), left(std::move(left)), right(std::move(right)) {
+    }
+
+    Rope::~Rope() {
+        std::vector<std::shared_ptr<Rope> > pending;
+        pending.push_back(std::move(left));
+        pending.push_back(std::move(right));
+        while (!pending.empty()) {
+            const std::shared_ptr<Rope> node = std::move(pending.back());
+            pending.pop_back();
+            // Detach the children of a node about to die, so its destructor finds nothing to release
+            if (node && node.use_count() == 1) {
+                pending.push_back(std::move(node->left));
+                pending.push_back(std::move(node->right));
+            }
+        }
+    }
+
+    std::shared_ptr<Rope> Rope::concat(const std::shared_ptr<Rope> &a, const std::shared_ptr<Rope> &b) {
+        if (a->length == 0) return b;
+        if (b->length == 0) return a;
+        if (a->length + b->length <= LEAF_MAX) {
+            return std::make_shared<Rope>(a->flat() + b->flat());
+        }
+        // Appending a short piece tops up the last leaf instead of adding a node
+        if (a->left && !a->right->left && a->right->length + b->length <= LEAF_MAX) {
+            return std::make_shared<Rope>(a->left, std::make_shared<Rope>(a->right->text + b->flat()));
+        }
+        return std::make_shared<Rope>(a, b);
+    }
+
+    const std::string &Rope::flat() const {
+        if (left) {
+            std::string whole;
+            whole.reserve(length);
+            for_each_chunk([&](const std::string_view chunk) {
+                whole.append(chunk);
+            });
+            text = std::move(whole);
+            left.reset();
+            right.reset();
+        }
+        return text;
+    }
+
+    [[nodiscard]] std::string Rope::to_string() const {
+        return flat();
+    }
+
+    std::ostream &operator<<(std::ostream &os, const Rope &rope) {
+        rope.for_each_chunk([&](const std::string_view chunk) {
+            os << chunk;
+        });
+        return os;
+    }
+
+    // Ropes are keyed by their text, so they find the Strings they spell
+    static const std::string *key_text(const Value &value) {
+        if (const auto *str = std::get_if<std::string>(&value)) {
+            return str;
+        }
+        if (const auto *rope = std::get_if<std::shared_ptr<Rope> >(&value)) {
+            return &(*rope)->flat();
+        }
+        return nullptr;
+    }
+
+    size_t ValueHash::operator()(const Value &value) const {
+        if (const auto *number = std::get_if<double>(&value)) {
+            if (std::isnan(*number)) {
+                return std::hash<double>{}(std::numeric_limits<double>::quiet_NaN());
+            }
+            return std::hash<double>{}(*number == 0 ? 0.0 : *number);
+        }
+        if (const std::string *text = key_text(value)) {
+            return std::hash<std::string>{}(*text);
+        }
+        return value.index();
+    }
+
+    bool ValueEq::operator()(const Value &a, const Value &b) const {
+        if (const auto *number = std::get_if<double>(&a)) {
+            const auto *other = std::get_if<double>(&b);
+            return other && (*number == *other || (std::isnan(*number) && std::isnan(*other)));
+        }
+        const std::string *x = key_text(a);
+        const std::string *y = key_text(b);
+        return x && y && *x == *y;
+    }
+
+    [[nodiscard]] std::string Dict::to_string() const {
+        std::ostringstream oss;
+        oss << "{";
+        size_t i = 0;
+        entries.for_each([&](const Value &key, const Value &value) {
+            oss << escape(key.to_string()) << ": " << escape(value.to_string());
+            if (++i != entries.size()) {
+                oss << ", ";
+            }
+        });
+        oss << "}";
+        return oss.str();
+    }
+
+    std::ostream &operator<<(std::ostream &os, const Dict &dict) {
+        return os << dict.to_string();
+    }
+
     [[nodiscard]] std::string NativeFunction::to_string() const {
         std::ostringstream oss;
         oss << "<native_fn: " << name << " " << arity << ">";
@@ -73,24 +327,108 @@ namespace intp::interp {
         return os << native_fn.to_string();
     }
 
-    Thunk::Thunk(const fe::ast::Expression *expr, std::shared_ptr<Env> env,
-                 std::optional<fe::loc::Loc> origin) : expr(expr), env(std::move(env)), origin(std::move(origin)) {
+    Thunk::Thunk() {
+        LBD_STAT_INC(thunks_created);
+        heap::on_create(this, heap::Kind::Thunk);
     }
 
+    Thunk::Thunk(const fe::ast::Arena *arena, const fe::ast::ExprId expr, std::shared_ptr<Env> env,
+                 std::optional<fe::loc::Loc> origin) : arena(arena), expr(expr), env(std::move(env)),
+                                                       origin(std::move(origin)) {
+        LBD_STAT_INC(thunks_created);
+        heap::on_create(this, heap::Kind::Thunk, this->origin);
+    }
+
+    Thunk::~Thunk() {
+        heap::on_destroy(this);
+    }
+
+    /// Global Thunks currently being forced on this thread, innermost last
+    static thread_local std::vector<const Thunk *> forcing_stack;
+
+    struct ForcingFrame {
+        explicit ForcingFrame(const Thunk *thunk) {
+            forcing_stack.push_back(thunk);
+        }
+
+        ~ForcingFrame() {
+            forcing_stack.pop_back();
+        }
+
+        ForcingFrame(const ForcingFrame &) = delete;
+
+        ForcingFrame &operator=(const ForcingFrame &) = delete;
+    };
+
     const Value &Thunk::force() const {
+        if (global && !forcing_stack.empty() && forcing_stack.back() != this) {
+            // Globals are read repeatedly by the same reader inside loops, skip the table for those
+            if (const Thunk *reader = forcing_stack.back(); reader != last_reader) {
+                add_dependent(reader);
+            }
+        }
+        LBD_STAT_INC(thunks_forced);
         if (cached.has_value()) {
+            LBD_STAT_INC(thunk_cache_hits);
             return cached.value();
         }
         // Expression is not initialized
-        if (!expr) {
+        if (!arena) {
             options_v.logger.error(origin, "runtime error: forcing empty thunk");
         }
-        cached = eval_expr(*expr, env);
+        const profiler::DefinitionScope profile_scope(origin);
+        LBD_STAT_DEPTH_SCOPE();
+        if (global) {
+            ForcingFrame frame(this);
+            cached = eval_expr(*arena, expr, env);
+        } else {
+            cached = eval_expr(*arena, expr, env);
+        }
+        if (frozen) {
+            cow::on_computed(*this);
+        }
         return cached.value();
     }
 
-    void Thunk::set(const fe::ast::Expression *expr_, std::shared_ptr<Env> env_,
+    void Thunk::add_dependent(const Thunk *reader) const {
+        last_reader = reader;
+        auto [it, inserted] = dependents.try_emplace(reader, reader->weak_from_this());
+        if (!inserted) {
+            // A dead reader's address can be reused by a new Thunk
+            if (it->second.expired()) {
+                it->second = reader->weak_from_this();
+            }
+            return;
+        }
+        // Readers of a long-lived global come and go, drop the dead ones whenever the table doubles
+        if (dependents.size() >= prune_dependents_at) {
+            std::erase_if(dependents, [](const auto &entry) {
+                return entry.second.expired();
+            });
+            prune_dependents_at = static_cast<uint32_t>(std::max<size_t>(8, 2 * dependents.size()));
+        }
+    }
+
+    size_t Thunk::invalidate_dependents() const {
+        // Detach first, so cycles between recursive bindings terminate. Expired entries go with the old table.
+        const auto dependents_ = std::move(dependents);
+        dependents.clear();
+        last_reader = nullptr;
+        prune_dependents_at = 8;
+        size_t count = 0;
+        for (const auto &[_, weak_dependent]: dependents_) {
+            if (const auto dependent = weak_dependent.lock()) {
+                count += dependent->cached.has_value();
+                dependent->cached.reset();
+                count += dependent->invalidate_dependents();
+            }
+        }
+        return count;
+    }
+
+    void Thunk::set(const fe::ast::Arena *arena_, const fe::ast::ExprId expr_, std::shared_ptr<Env> env_,
                     std::optional<fe::loc::Loc> origin_) {
+        arena = arena_;
         expr = expr_;
         owned.reset();
         env = std::move(env_);
@@ -100,10 +438,11 @@ namespace intp::interp {
         cached.reset();
     }
 
-    void Thunk::set_owned(fe::ast::Expression expr_, std::shared_ptr<Env> env_,
-                          std::optional<fe::loc::Loc> origin_) {
-        owned = std::make_unique<fe::ast::Expression>(std::move(expr_));
-        expr = owned.get();
+    void Thunk::set_owned(std::shared_ptr<const fe::ast::Arena> arena_, const fe::ast::ExprId expr_,
+                          std::shared_ptr<Env> env_, std::optional<fe::loc::Loc> origin_) {
+        owned = std::move(arena_);
+        arena = owned.get();
+        expr = expr_;
         env = std::move(env_);
         if (origin_.has_value()) {
             origin = std::move(origin_.value());
@@ -112,6 +451,12 @@ namespace intp::interp {
     }
 
     Env::Env(std::shared_ptr<Env> parent) : parent(std::move(parent)) {
+        LBD_STAT_INC(env_frames);
+        heap::on_create(this, heap::Kind::Env);
+    }
+
+    Env::~Env() {
+        heap::on_destroy(this);
     }
 
     std::shared_ptr<Thunk> Env::lookup(const std::string &name) const {
@@ -126,7 +471,13 @@ namespace intp::interp {
     }
 
     void Env::bind(const std::string &name, std::shared_ptr<Thunk> thunk) {
-        table[name] = std::move(thunk);
+        auto &slot = table[name];
+        if (slot && slot != thunk && slot->global) {
+            if (const size_t count = slot->invalidate_dependents(); count > 0 && options_v.debug) {
+                options_v.logger.debug("debug: redefining ", name, " invalidated ", count, " dependent value(s)");
+            }
+        }
+        slot = std::move(thunk);
     }
 
     std::vector<std::vector<std::string> > Env::to_vector(const bool force) const {
@@ -161,26 +512,32 @@ namespace intp::interp {
         return thunk->force();
     }
 
-    static Value eval_lambda_expr(const fe::ast::LambdaExpression &l_expr, const std::shared_ptr<Env> &env) {
-        return Value(Closure{l_expr.arg.value, l_expr.expr.get(), env});
+    static Value eval_lambda_expr(const fe::ast::Arena &arena, const fe::ast::LambdaExpression &l_expr,
+                                  const std::shared_ptr<Env> &env) {
+        if (heap::enabled) {
+            heap::count_closure(l_expr.loc);
+        }
+        return Value(Closure{l_expr.arg.value, &arena, l_expr.expr, env});
     }
 
-    static Value eval_fn_apl(const fe::ast::FunctionApplication &fn_apl, const std::shared_ptr<Env> &env) {
+    static Value eval_fn_apl(const fe::ast::Arena &arena, const fe::ast::FunctionApplication &fn_apl,
+                             const std::shared_ptr<Env> &env) {
         // Lookup the callee lazily
         const auto callee_thunk = env->lookup(fn_apl.fn_name.value);
         if (!callee_thunk) {
             options_v.logger.error(fn_apl.loc, "runtime error: undefined function ", fn_apl.fn_name.value);
         }
         const Value fn_value = callee_thunk->force();
+        const heap::SiteScope heap_scope(fn_apl.loc);
         std::vector<std::shared_ptr<Thunk> > arg_thunks;
-        arg_thunks.reserve(fn_apl.args.size());
-        for (const auto &arg: fn_apl.args) {
-            arg_thunks.push_back(std::make_shared<Thunk>(arg.get(), env));
+        arg_thunks.reserve(fn_apl.args_count);
+        for (const fe::ast::ExprId arg: arena.args_of(fn_apl)) {
+            arg_thunks.push_back(std::make_shared<Thunk>(&arena, arg, env));
         }
-        return apply_fn_apl(fn_value, arg_thunks, env, fn_apl.loc);
+        return apply_fn_apl(fn_value, arg_thunks, env, fn_apl.loc, fn_apl.fn_name.value);
     }
 
-    Value eval_expr(const fe::ast::Expression &expr, std::shared_ptr<Env> env) {
+    Value eval_expr(const fe::ast::Arena &arena, const fe::ast::ExprId expr, std::shared_ptr<Env> env) {
         return std::visit([&]<typename T0>(T0 &&arg) {
             using T = std::decay_t<T0>;
             if constexpr (std::is_same_v<T, fe::ast::IdenAstNode>) {
@@ -189,13 +546,13 @@ namespace intp::interp {
                                      fe::ast::FloatAstNode>) {
                 return Value(arg.value);
             } else if constexpr (std::is_same_v<T, fe::ast::LambdaExpression>) {
-                return eval_lambda_expr(arg, env);
+                return eval_lambda_expr(arena, arg, env);
             } else if constexpr (std::is_same_v<T, fe::ast::FunctionApplication>) {
-                return eval_fn_apl(arg, env);
+                return eval_fn_apl(arena, arg, env);
             } else {
                 STATIC_ASSERT_UNREACHABLE_T(T, "unhandled expression");
             }
-        }, expr.value);
+        }, arena[expr].value);
     }
 
     static std::shared_ptr<Thunk> value_to_thunk(const Value &v) {
@@ -204,8 +561,46 @@ namespace intp::interp {
         return t;
     }
 
+    // Native calls are traced only when slower than the threshold, most builtins are cheap
+    static std::pair<Value, ResultOptions> call_native(const NativeFunction::Impl &impl, const std::string &name,
+                                                       const std::vector<std::shared_ptr<Thunk> > &args,
+                                                       const std::shared_ptr<Env> &call_site_env,
+                                                       const std::optional<fe::loc::Loc> &call_loc) {
+        if (!fe::trace::enabled) {
+            return impl(args, call_site_env);
+        }
+        const uint64_t start_us = fe::trace::now_us();
+        auto result = impl(args, call_site_env);
+        if (const uint64_t dur_us = fe::trace::now_us() - start_us; dur_us >= fe::trace::builtin_threshold_us) {
+            std::string args_json;
+            if (call_loc) {
+                std::ostringstream oss;
+                oss << *call_loc;
+                args_json = "\"loc\": " + fe::trace::quote(oss.str());
+            }
+            fe::trace::record(name, "builtin", start_us, dur_us, std::move(args_json));
+        }
+        return result;
+    }
+
+    // Profiler label for a call, the name it was called by where known
+    static std::string_view call_label(const Value &fn_value, const std::string_view callee) {
+        if (!callee.empty()) {
+            return callee;
+        }
+        if (const auto *native_fn = std::get_if<std::shared_ptr<NativeFunction> >(&fn_value)) {
+            return (*native_fn)->name;
+        }
+        return "lambda";
+    }
+
     Value apply_fn_apl(Value fn_value, const std::vector<std::shared_ptr<Thunk> > &args,
-                       const std::shared_ptr<Env> &call_site_env, const std::optional<fe::loc::Loc> &call_loc) {
+                       const std::shared_ptr<Env> &call_site_env, const std::optional<fe::loc::Loc> &call_loc,
+                       const std::string_view callee) {
+        const profiler::CallScope profile_scope(call_loc, profiler::enabled
+                                                              ? call_label(fn_value, callee)
+                                                              : std::string_view{});
+        LBD_STAT_DEPTH_SCOPE();
         // Local mutable copy of the args, for inserting evaluated values as Thunks when needed.
         std::vector<std::shared_ptr<Thunk> > work_args = args;
         // Frame Stack: Functions to which we are currently applying Arguments.
@@ -230,7 +625,9 @@ namespace intp::interp {
                     if (const auto &native_fn = *std::get<std::shared_ptr<NativeFunction> >(current_fn);
                         native_fn.arity == 0 || native_fn.arity == -1) {
                         std::vector<std::shared_ptr<Thunk> > slice; // empty
-                        auto [value, result_options] = native_fn.impl(slice, call_site_env);
+                        LBD_STAT_NATIVE_CALL(native_fn.calls);
+                        auto [value, result_options] = call_native(native_fn.impl, native_fn.name, slice, call_site_env,
+                                                                  call_loc);
                         global_result_options.interpolate(result_options);
                         return value;
                     }
@@ -246,15 +643,16 @@ namespace intp::interp {
             }
             // Closure case: Closure consumes exactly one Argument (its Param)
             if (std::holds_alternative<Closure>(current_fn)) {
-                const auto [param, body, env] = std::get<Closure>(current_fn);
+                const auto [param, arena, body, env] = std::get<Closure>(current_fn);
                 const auto &arg_thunk = work_args[idx++];
+                LBD_STAT_INC(closure_applications);
                 const auto child_env = std::make_shared<Env>(env);
                 child_env->bind(param, arg_thunk);
-                resultant_value = eval_expr(*body, child_env);
+                resultant_value = eval_expr(*arena, body, child_env);
             }
             // Native Function case: Consumes its arity-many Argument Thunks
             else if (std::holds_alternative<std::shared_ptr<NativeFunction> >(current_fn)) {
-                if (const auto &[arity, name, impl] = *std::get<std::shared_ptr<NativeFunction> >(current_fn);
+                if (const auto &[arity, name, impl, calls] = *std::get<std::shared_ptr<NativeFunction> >(current_fn);
                     arity != -1) {
                     if (work_args.size() - idx < arity) {
                         options_v.logger.error(call_loc, "runtime error: native function ", name, " expects ", arity,
@@ -265,7 +663,8 @@ namespace intp::interp {
                     for (size_t i = 0; i < arity; ++i) {
                         slice.push_back(work_args[idx + i]);
                     }
-                    auto [resultant_value_, result_options] = impl(slice, call_site_env);
+                    LBD_STAT_NATIVE_CALL(calls);
+                    auto [resultant_value_, result_options] = call_native(impl, name, slice, call_site_env, call_loc);
                     resultant_value = resultant_value_;
                     global_result_options.interpolate(result_options);
                     idx += arity;
@@ -275,7 +674,8 @@ namespace intp::interp {
                     for (size_t i = 0; i < args.size() - idx; ++i) {
                         slice.push_back(work_args[idx + i]);
                     }
-                    auto [resultant_value_, result_options] = impl(slice, call_site_env);
+                    LBD_STAT_NATIVE_CALL(calls);
+                    auto [resultant_value_, result_options] = call_native(impl, name, slice, call_site_env, call_loc);
                     resultant_value = resultant_value_;
                     global_result_options.interpolate(result_options);
                     idx += args.size() - idx;
@@ -318,21 +718,100 @@ namespace intp::interp {
         }
     }
 
+    RepeatedCall::RepeatedCall(Value fn, std::shared_ptr<Env> call_site_env, const size_t arity)
+        : fn(std::move(fn)), call_site_env(std::move(call_site_env)), slots(arity) {
+        const auto *closure = std::get_if<Closure>(&this->fn);
+        if (!closure || arity == 0) return;
+        params.push_back(closure->param);
+        body = closure->body;
+        while (params.size() < arity) {
+            const auto *lambda = std::get_if<fe::ast::LambdaExpression>(&(*closure->arena)[body].value);
+            if (!lambda) {
+                params.clear();
+                return;
+            }
+            params.push_back(lambda->arg.value);
+            body = lambda->expr;
+        }
+    }
+
+    bool RepeatedCall::reusable() const {
+        const long slot_owners = frames.empty() ? 1 : 2;
+        for (const auto &slot: slots) {
+            if (!slot || slot.use_count() != slot_owners) return false;
+        }
+        for (size_t i = 0; i < frames.size(); ++i) {
+            // A frame is also the parent of the next one
+            if (frames[i].use_count() != (i + 1 < frames.size() ? 2 : 1)) return false;
+        }
+        return true;
+    }
+
+    Value RepeatedCall::operator()(const std::span<Value> args) {
+        const profiler::CallScope profile_scope(std::nullopt, profiler::enabled
+                                                                  ? call_label(fn, {})
+                                                                  : std::string_view{});
+        LBD_STAT_DEPTH_SCOPE();
+        if (!reusable()) {
+            for (auto &slot: slots) {
+                slot = std::make_shared<Thunk>();
+            }
+            frames.clear();
+        }
+        for (size_t i = 0; i < slots.size(); ++i) {
+            slots[i]->cached = std::move(args[i]);
+        }
+        if (!params.empty()) {
+            // Same frames apply_fn_apl would build, one Closure application per parameter
+            const auto &closure = std::get<Closure>(fn);
+            if (frames.empty()) {
+                std::shared_ptr<Env> parent = closure.env;
+                for (size_t i = 0; i < params.size(); ++i) {
+                    parent = std::make_shared<Env>(std::move(parent));
+                    parent->bind(params[i], slots[i]);
+                    frames.push_back(parent);
+                }
+            }
+            for (size_t i = 0; i < params.size(); ++i) {
+                LBD_STAT_INC(closure_applications);
+            }
+            return eval_expr(*closure.arena, body, frames.back());
+        }
+        if (const auto *native_fn = std::get_if<std::shared_ptr<NativeFunction> >(&fn);
+            native_fn && (*native_fn)->arity == static_cast<int>(slots.size())) {
+            const auto &[arity, name, impl, calls] = **native_fn;
+            LBD_STAT_NATIVE_CALL(calls);
+            auto [value, result_options] = call_native(impl, name, slots, call_site_env, std::nullopt);
+            global_result_options.interpolate(result_options);
+            return value;
+        }
+        return apply_fn_apl(fn, slots, call_site_env);
+    }
+
     // Creates placeholder Thunk then set body so recursion can refer to it during lazy evaluation
-    static void bind_def_ast_node_lazy(fe::ast::DefAstNode &def_ast_node, const std::shared_ptr<Env> &env,
-                                       const options::Options options) {
+    static void bind_def_ast_node_lazy(const std::shared_ptr<fe::ast::Arena> &arena,
+                                       const fe::ast::DefAstNode &def_ast_node, const std::shared_ptr<Env> &env,
+                                       const options::Options &options) {
         const auto thunk = std::make_shared<Thunk>();
+        thunk->global = options.track_dependencies;
         env->bind(def_ast_node.def_name.value, thunk);
+        const fe::loc::Loc origin = (*arena)[def_ast_node.expr].get_loc();
+        profiler::name_definition(origin, def_ast_node.def_name.value);
         if (options.own_expr) {
-            thunk->set_owned(std::move(def_ast_node.expr), env, def_ast_node.expr.get_loc());
+            thunk->set_owned(arena, def_ast_node.expr, env, origin);
         } else {
-            thunk->set(&def_ast_node.expr, env, def_ast_node.expr.get_loc());
+            thunk->set(arena.get(), def_ast_node.expr, env, origin);
+        }
+        if (heap::enabled) {
+            heap::track(thunk.get(), heap::Kind::Thunk, origin);
         }
     }
 
     Result interpret(fe::ast::Program &program, std::optional<std::shared_ptr<Env> > global_env,
                      const options::Options options_) {
         options_v = options_;
+        // Side effects are reported per call, a REPL input or serve request must not inherit earlier ones
+        global_result_options = {};
         if (!global_env) {
             global_env = std::make_shared<Env>();
             install_builtins(*global_env);
@@ -341,10 +820,19 @@ namespace intp::interp {
         for (auto &[value]: program.nodes) {
             std::visit([&]<typename T0>(T0 &&arg) {
                 using T = std::decay_t<T0>;
-                if constexpr (std::is_same_v<T, fe::ast::Expression>) {
-                    result_value = eval_expr(arg, *global_env);
+                fe::trace::Span span("eval");
+                if constexpr (std::is_same_v<T, fe::ast::ExprId>) {
+                    if (span) {
+                        std::ostringstream oss;
+                        oss << "eval " << (*program.arena)[arg].get_loc();
+                        span.name = oss.str();
+                    }
+                    result_value = eval_expr(*program.arena, arg, *global_env);
                 } else if constexpr (std::is_same_v<T, fe::ast::DefAstNode>) {
-                    bind_def_ast_node_lazy(arg, *global_env, options_v);
+                    if (span) {
+                        span.name = "bind " + arg.def_name.value;
+                    }
+                    bind_def_ast_node_lazy(program.arena, arg, *global_env, options_v);
                     const fe::ast::DefAstNode &def_ast_node = arg;
                     result_value = def_ast_node.def_name.value;
                 } else {
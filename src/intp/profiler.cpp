@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <lbd/intp/profiler.h>
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <sys/time.h>
+#endif
+
+namespace intp::profiler {
+    using Clock = std::chrono::steady_clock;
+
+    struct Site {
+        std::string label;
+    };
+
+    /// Call tree node, children are keyed by Site index
+    struct Node {
+        uint32_t site;
+        Node *parent;
+        std::unordered_map<uint32_t, std::unique_ptr<Node> > children;
+        uint64_t calls = 0;
+        uint64_t total_ns = 0; /// Outermost activations only, recursion is not counted twice
+        uint64_t self_ns = 0;
+        std::atomic<uint64_t> samples = 0;
+        uint32_t active = 0; /// Activations currently on the stack
+
+        Node(const uint32_t site, Node *parent) : site(site), parent(parent) {
+        }
+    };
+
+    struct Frame {
+        Node *node;
+        Node *prev; /// Current node before entering, differs from node->parent when folded
+        Clock::time_point start;
+        uint64_t children_ns = 0;
+    };
+
+    static constexpr uint32_t ROOT_SITE = UINT32_MAX;
+
+    static std::unordered_map<uint64_t, std::string> definition_names;
+    static std::vector<Site> sites;
+    static std::unordered_map<uint64_t, uint32_t> definition_sites;
+    static std::unordered_map<uint64_t, uint32_t> call_sites;
+    static std::unordered_map<std::string, uint32_t> named_call_sites; /// Calls without a source location
+    static std::unique_ptr<Node> root;
+    static std::atomic<Node *> current = nullptr; /// Read by the SIGPROF handler
+    static std::vector<Frame> frames;
+
+    static uint64_t loc_key(const fe::loc::Loc &loc) {
+        return static_cast<uint64_t>(loc.file_id) << 32 | loc.offset;
+    }
+
+    static std::string loc_string(const fe::loc::Loc &loc) {
+        std::ostringstream oss;
+        oss << loc;
+        return oss.str();
+    }
+
+    void name_definition(const fe::loc::Loc &loc, const std::string &name) {
+        definition_names[loc_key(loc)] = name;
+    }
+
+    static uint32_t add_site(std::string label) {
+        sites.push_back({std::move(label)});
+        return static_cast<uint32_t>(sites.size() - 1);
+    }
+
+    static void enter(const uint32_t site) {
+        Node *cur = current.load(std::memory_order_relaxed);
+        // Fold recursion into the active ancestor of the same site
+        Node *target = nullptr;
+        for (Node *node = cur; node; node = node->parent) {
+            if (node->site == site) {
+                target = node;
+                break;
+            }
+        }
+        if (!target) {
+            auto &child = cur->children[site];
+            if (!child) {
+                child = std::make_unique<Node>(site, cur);
+            }
+            target = child.get();
+        }
+        ++target->calls;
+        ++target->active;
+        frames.push_back({target, cur, Clock::now()});
+        current.store(target, std::memory_order_relaxed);
+    }
+
+    void enter_definition(const fe::loc::Loc &loc) {
+        const uint64_t key = loc_key(loc);
+        auto [it, inserted] = definition_sites.try_emplace(key, 0);
+        if (inserted) {
+            const auto name = definition_names.find(key);
+            it->second = add_site(name != definition_names.end() ? name->second : "<thunk " + loc_string(loc) + ">");
+        }
+        enter(it->second);
+    }
+
+    void enter_call(const std::optional<fe::loc::Loc> &loc, const std::string_view name) {
+        uint32_t site;
+        if (loc) {
+            auto [it, inserted] = call_sites.try_emplace(loc_key(*loc), 0);
+            if (inserted) {
+                it->second = add_site(std::string(name) + " (" + loc_string(*loc) + ")");
+            }
+            site = it->second;
+        } else {
+            auto [it, inserted] = named_call_sites.try_emplace(std::string(name), 0);
+            if (inserted) {
+                it->second = add_site(std::string(name));
+            }
+            site = it->second;
+        }
+        enter(site);
+    }
+
+    void leave() {
+        const Frame frame = frames.back();
+        frames.pop_back();
+        const auto elapsed = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame.start).count());
+        frame.node->self_ns += elapsed - std::min(elapsed, frame.children_ns);
+        if (--frame.node->active == 0) {
+            frame.node->total_ns += elapsed;
+        }
+        if (!frames.empty()) {
+            frames.back().children_ns += elapsed;
+        }
+        current.store(frame.prev, std::memory_order_relaxed);
+    }
+
+#if !defined(_WIN32)
+    static void on_sigprof(int) {
+        if (Node *node = current.load(std::memory_order_relaxed)) {
+            node->samples.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+#endif
+
+    void start() {
+        stop();
+        sites.clear();
+        definition_sites.clear();
+        call_sites.clear();
+        named_call_sites.clear();
+        frames.clear();
+        root = std::make_unique<Node>(ROOT_SITE, nullptr);
+        current.store(root.get());
+        enabled = true;
+#if !defined(_WIN32)
+        struct sigaction action{};
+        action.sa_handler = on_sigprof;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF, &action, nullptr);
+        itimerval timer{};
+        timer.it_interval.tv_usec = 1000; // 1 kHz
+        timer.it_value.tv_usec = 1000;
+        setitimer(ITIMER_PROF, &timer, nullptr);
+#endif
+    }
+
+    void stop() {
+        if (!enabled) {
+            return;
+        }
+#if !defined(_WIN32)
+        constexpr itimerval timer{};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        signal(SIGPROF, SIG_IGN);
+#endif
+        enabled = false;
+        // Frames still open (an error unwound past them without a Scope) are closed at stop time
+        while (!frames.empty()) {
+            leave();
+        }
+    }
+
+    struct SiteTotals {
+        uint64_t calls = 0;
+        uint64_t total_ns = 0;
+        uint64_t self_ns = 0;
+        uint64_t samples = 0;
+    };
+
+    // A site is only added to its total once per path, nested occurrences are already inside the outer one
+    static void accumulate(const Node &node, std::vector<SiteTotals> &totals, std::vector<uint32_t> &on_path) {
+        if (node.site != ROOT_SITE) {
+            auto &t = totals[node.site];
+            t.calls += node.calls;
+            t.self_ns += node.self_ns;
+            t.samples += node.samples.load(std::memory_order_relaxed);
+            if (std::find(on_path.begin(), on_path.end(), node.site) == on_path.end()) {
+                t.total_ns += node.total_ns;
+            }
+            on_path.push_back(node.site);
+        }
+        for (const auto &[_, child]: node.children) {
+            accumulate(*child, totals, on_path);
+        }
+        if (node.site != ROOT_SITE) {
+            on_path.pop_back();
+        }
+    }
+
+    static std::string format_ms(const uint64_t ns) {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3) << static_cast<double>(ns) / 1e6;
+        return oss.str();
+    }
+
+    void report(std::ostream &os, const size_t limit) {
+        if (!root) {
+            os << "profile: no data" << std::endl;
+            return;
+        }
+        std::vector<SiteTotals> totals(sites.size());
+        std::vector<uint32_t> on_path;
+        accumulate(*root, totals, on_path);
+        std::vector<uint32_t> order(sites.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) {
+            if (totals[a].total_ns != totals[b].total_ns) return totals[a].total_ns > totals[b].total_ns;
+            return sites[a].label < sites[b].label;
+        });
+        if (limit != 0 && order.size() > limit) {
+            order.resize(limit);
+        }
+        os << std::right << std::setw(10) << "calls" << std::setw(14) << "total ms" << std::setw(14) << "self ms"
+                << std::setw(10) << "samples" << "  site" << std::endl;
+        for (const uint32_t i: order) {
+            os << std::setw(10) << totals[i].calls << std::setw(14) << format_ms(totals[i].total_ns)
+                    << std::setw(14) << format_ms(totals[i].self_ns) << std::setw(10) << totals[i].samples
+                    << "  " << sites[i].label << std::endl;
+        }
+    }
+
+    static void collapse(const Node &node, std::string &path, std::vector<std::string> &lines) {
+        const size_t path_size = path.size();
+        if (node.site != ROOT_SITE) {
+            if (!path.empty()) {
+                path += ';';
+            }
+            path += sites[node.site].label;
+            if (const uint64_t self_us = node.self_ns / 1000; self_us > 0) {
+                lines.push_back(path + " " + std::to_string(self_us));
+            }
+        }
+        for (const auto &[_, child]: node.children) {
+            collapse(*child, path, lines);
+        }
+        path.resize(path_size);
+    }
+
+    void write_collapsed(std::ostream &os) {
+        if (!root) {
+            return;
+        }
+        std::string path;
+        std::vector<std::string> lines;
+        collapse(*root, path, lines);
+        std::sort(lines.begin(), lines.end());
+        for (const auto &line: lines) {
+            os << line << '\n';
+        }
+    }
+}
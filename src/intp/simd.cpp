@@ -0,0 +1,371 @@
+#include <cstdlib>
+#include <limits>
+#include <string_view>
+#include <lbd/intp/simd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LBD_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace intp::simd {
+    struct Kernels {
+        const char *isa;
+        double (*sum)(const double *, size_t);
+        double (*product)(const double *, size_t);
+        double (*min)(const double *, size_t);
+        double (*max)(const double *, size_t);
+        double (*dot)(const double *, const double *, size_t);
+        void (*add)(const double *, const double *, double *, size_t);
+        void (*sub)(const double *, const double *, double *, size_t);
+        void (*mul)(const double *, const double *, double *, size_t);
+        void (*scale)(double, const double *, double *, size_t);
+    };
+
+    static constexpr double NAN_V = std::numeric_limits<double>::quiet_NaN();
+
+    namespace scalar {
+        static double sum(const double *x, const size_t n) {
+            double acc = 0;
+            for (size_t i = 0; i < n; ++i) acc += x[i];
+            return acc;
+        }
+
+        static double product(const double *x, const size_t n) {
+            double acc = 1;
+            for (size_t i = 0; i < n; ++i) acc *= x[i];
+            return acc;
+        }
+
+        // Least of acc and x[0..n), NaN as soon as any of them is NaN
+        static double min_from(double acc, const double *x, const size_t n) {
+            if (acc != acc) return NAN_V;
+            for (size_t i = 0; i < n; ++i) {
+                if (x[i] != x[i]) return NAN_V;
+                if (x[i] < acc) acc = x[i];
+            }
+            return acc;
+        }
+
+        static double max_from(double acc, const double *x, const size_t n) {
+            if (acc != acc) return NAN_V;
+            for (size_t i = 0; i < n; ++i) {
+                if (x[i] != x[i]) return NAN_V;
+                if (x[i] > acc) acc = x[i];
+            }
+            return acc;
+        }
+
+        static double min(const double *x, const size_t n) {
+            return min_from(x[0], x + 1, n - 1);
+        }
+
+        static double max(const double *x, const size_t n) {
+            return max_from(x[0], x + 1, n - 1);
+        }
+
+        static double dot(const double *x, const double *y, const size_t n) {
+            double acc = 0;
+            for (size_t i = 0; i < n; ++i) acc += x[i] * y[i];
+            return acc;
+        }
+
+        static void add(const double *x, const double *y, double *out, const size_t n) {
+            for (size_t i = 0; i < n; ++i) out[i] = x[i] + y[i];
+        }
+
+        static void sub(const double *x, const double *y, double *out, const size_t n) {
+            for (size_t i = 0; i < n; ++i) out[i] = x[i] - y[i];
+        }
+
+        static void mul(const double *x, const double *y, double *out, const size_t n) {
+            for (size_t i = 0; i < n; ++i) out[i] = x[i] * y[i];
+        }
+
+        static void scale(const double k, const double *x, double *out, const size_t n) {
+            for (size_t i = 0; i < n; ++i) out[i] = k * x[i];
+        }
+    }
+
+#ifdef LBD_SIMD_X86
+    // Two independent accumulators per reduction hide the latency of the vector add
+    namespace sse2 {
+        __attribute__((target("sse2"))) static double hsum(const __m128d v) {
+            return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+        }
+
+        __attribute__((target("sse2"))) static double sum(const double *x, const size_t n) {
+            __m128d a = _mm_setzero_pd(), b = _mm_setzero_pd();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                a = _mm_add_pd(a, _mm_loadu_pd(x + i));
+                b = _mm_add_pd(b, _mm_loadu_pd(x + i + 2));
+            }
+            double acc = hsum(_mm_add_pd(a, b));
+            for (; i < n; ++i) acc += x[i];
+            return acc;
+        }
+
+        __attribute__((target("sse2"))) static double product(const double *x, const size_t n) {
+            __m128d a = _mm_set1_pd(1), b = _mm_set1_pd(1);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                a = _mm_mul_pd(a, _mm_loadu_pd(x + i));
+                b = _mm_mul_pd(b, _mm_loadu_pd(x + i + 2));
+            }
+            const __m128d c = _mm_mul_pd(a, b);
+            double acc = _mm_cvtsd_f64(_mm_mul_sd(c, _mm_unpackhi_pd(c, c)));
+            for (; i < n; ++i) acc *= x[i];
+            return acc;
+        }
+
+        // _mm_min_pd and _mm_max_pd return their second operand for a NaN, so NaNs are tracked in a separate mask
+        __attribute__((target("sse2"))) static double min(const double *x, const size_t n) {
+            if (n < 2) return scalar::min(x, n);
+            __m128d a = _mm_loadu_pd(x), unordered = _mm_cmpunord_pd(a, a);
+            size_t i = 2;
+            for (; i + 2 <= n; i += 2) {
+                const __m128d v = _mm_loadu_pd(x + i);
+                unordered = _mm_or_pd(unordered, _mm_cmpunord_pd(v, v));
+                a = _mm_min_pd(a, v);
+            }
+            if (_mm_movemask_pd(unordered)) return NAN_V;
+            return scalar::min_from(_mm_cvtsd_f64(_mm_min_sd(a, _mm_unpackhi_pd(a, a))), x + i, n - i);
+        }
+
+        __attribute__((target("sse2"))) static double max(const double *x, const size_t n) {
+            if (n < 2) return scalar::max(x, n);
+            __m128d a = _mm_loadu_pd(x), unordered = _mm_cmpunord_pd(a, a);
+            size_t i = 2;
+            for (; i + 2 <= n; i += 2) {
+                const __m128d v = _mm_loadu_pd(x + i);
+                unordered = _mm_or_pd(unordered, _mm_cmpunord_pd(v, v));
+                a = _mm_max_pd(a, v);
+            }
+            if (_mm_movemask_pd(unordered)) return NAN_V;
+            return scalar::max_from(_mm_cvtsd_f64(_mm_max_sd(a, _mm_unpackhi_pd(a, a))), x + i, n - i);
+        }
+
+        __attribute__((target("sse2"))) static double dot(const double *x, const double *y, const size_t n) {
+            __m128d a = _mm_setzero_pd(), b = _mm_setzero_pd();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                a = _mm_add_pd(a, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+                b = _mm_add_pd(b, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+            }
+            double acc = hsum(_mm_add_pd(a, b));
+            for (; i < n; ++i) acc += x[i] * y[i];
+            return acc;
+        }
+
+        __attribute__((target("sse2"))) static void add(const double *x, const double *y, double *out,
+                                                        const size_t n) {
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+            for (; i < n; ++i) out[i] = x[i] + y[i];
+        }
+
+        __attribute__((target("sse2"))) static void sub(const double *x, const double *y, double *out,
+                                                        const size_t n) {
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_sub_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+            for (; i < n; ++i) out[i] = x[i] - y[i];
+        }
+
+        __attribute__((target("sse2"))) static void mul(const double *x, const double *y, double *out,
+                                                        const size_t n) {
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+            for (; i < n; ++i) out[i] = x[i] * y[i];
+        }
+
+        __attribute__((target("sse2"))) static void scale(const double k, const double *x, double *out,
+                                                          const size_t n) {
+            const __m128d kv = _mm_set1_pd(k);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_mul_pd(kv, _mm_loadu_pd(x + i)));
+            for (; i < n; ++i) out[i] = k * x[i];
+        }
+    }
+
+    namespace avx2 {
+        __attribute__((target("avx2"))) static double hsum(const __m256d v) {
+            const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+        }
+
+        __attribute__((target("avx2"))) static double sum(const double *x, const size_t n) {
+            __m256d a = _mm256_setzero_pd(), b = _mm256_setzero_pd();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                a = _mm256_add_pd(a, _mm256_loadu_pd(x + i));
+                b = _mm256_add_pd(b, _mm256_loadu_pd(x + i + 4));
+            }
+            double acc = hsum(_mm256_add_pd(a, b));
+            for (; i < n; ++i) acc += x[i];
+            return acc;
+        }
+
+        __attribute__((target("avx2"))) static double product(const double *x, const size_t n) {
+            __m256d a = _mm256_set1_pd(1), b = _mm256_set1_pd(1);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                a = _mm256_mul_pd(a, _mm256_loadu_pd(x + i));
+                b = _mm256_mul_pd(b, _mm256_loadu_pd(x + i + 4));
+            }
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, _mm256_mul_pd(a, b));
+            double acc = lanes[0] * lanes[1] * lanes[2] * lanes[3];
+            for (; i < n; ++i) acc *= x[i];
+            return acc;
+        }
+
+        __attribute__((target("avx2"))) static double min(const double *x, const size_t n) {
+            if (n < 4) return scalar::min(x, n);
+            __m256d a = _mm256_loadu_pd(x), unordered = _mm256_cmp_pd(a, a, _CMP_UNORD_Q);
+            size_t i = 4;
+            for (; i + 4 <= n; i += 4) {
+                const __m256d v = _mm256_loadu_pd(x + i);
+                unordered = _mm256_or_pd(unordered, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+                a = _mm256_min_pd(a, v);
+            }
+            if (_mm256_movemask_pd(unordered)) return NAN_V;
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, a);
+            return scalar::min_from(scalar::min(lanes, 4), x + i, n - i);
+        }
+
+        __attribute__((target("avx2"))) static double max(const double *x, const size_t n) {
+            if (n < 4) return scalar::max(x, n);
+            __m256d a = _mm256_loadu_pd(x), unordered = _mm256_cmp_pd(a, a, _CMP_UNORD_Q);
+            size_t i = 4;
+            for (; i + 4 <= n; i += 4) {
+                const __m256d v = _mm256_loadu_pd(x + i);
+                unordered = _mm256_or_pd(unordered, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+                a = _mm256_max_pd(a, v);
+            }
+            if (_mm256_movemask_pd(unordered)) return NAN_V;
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, a);
+            return scalar::max_from(scalar::max(lanes, 4), x + i, n - i);
+        }
+
+        __attribute__((target("avx2"))) static double dot(const double *x, const double *y, const size_t n) {
+            __m256d a = _mm256_setzero_pd(), b = _mm256_setzero_pd();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                a = _mm256_add_pd(a, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+                b = _mm256_add_pd(b, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+            }
+            double acc = hsum(_mm256_add_pd(a, b));
+            for (; i < n; ++i) acc += x[i] * y[i];
+            return acc;
+        }
+
+        __attribute__((target("avx2"))) static void add(const double *x, const double *y, double *out,
+                                                        const size_t n) {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+            }
+            for (; i < n; ++i) out[i] = x[i] + y[i];
+        }
+
+        __attribute__((target("avx2"))) static void sub(const double *x, const double *y, double *out,
+                                                        const size_t n) {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+            }
+            for (; i < n; ++i) out[i] = x[i] - y[i];
+        }
+
+        __attribute__((target("avx2"))) static void mul(const double *x, const double *y, double *out,
+                                                        const size_t n) {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+            }
+            for (; i < n; ++i) out[i] = x[i] * y[i];
+        }
+
+        __attribute__((target("avx2"))) static void scale(const double k, const double *x, double *out,
+                                                          const size_t n) {
+            const __m256d kv = _mm256_set1_pd(k);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_mul_pd(kv, _mm256_loadu_pd(x + i)));
+            for (; i < n; ++i) out[i] = k * x[i];
+        }
+    }
+#endif
+
+    static Kernels select() {
+#ifdef LBD_SIMD_X86
+        // LBD_SIMD=sse2 or LBD_SIMD=scalar caps the instruction set, so tests can compare the implementations
+        const char *cap = std::getenv("LBD_SIMD");
+        const std::string_view limit = cap ? cap : "";
+        __builtin_cpu_init();
+        if (limit != "sse2" && limit != "scalar" && __builtin_cpu_supports("avx2")) {
+            return {
+                "avx2", avx2::sum, avx2::product, avx2::min, avx2::max, avx2::dot, avx2::add, avx2::sub, avx2::mul,
+                avx2::scale
+            };
+        }
+        if (limit != "scalar" && __builtin_cpu_supports("sse2")) {
+            return {
+                "sse2", sse2::sum, sse2::product, sse2::min, sse2::max, sse2::dot, sse2::add, sse2::sub, sse2::mul,
+                sse2::scale
+            };
+        }
+#endif
+        return {
+            "scalar", scalar::sum, scalar::product, scalar::min, scalar::max, scalar::dot, scalar::add, scalar::sub,
+            scalar::mul, scalar::scale
+        };
+    }
+
+    static const Kernels &kernels() {
+        static const Kernels selected = select();
+        return selected;
+    }
+
+    double sum(const double *x, const size_t n) {
+        return kernels().sum(x, n);
+    }
+
+    double product(const double *x, const size_t n) {
+        return kernels().product(x, n);
+    }
+
+    double min(const double *x, const size_t n) {
+        return kernels().min(x, n);
+    }
+
+    double max(const double *x, const size_t n) {
+        return kernels().max(x, n);
+    }
+
+    double dot(const double *x, const double *y, const size_t n) {
+        return kernels().dot(x, y, n);
+    }
+
+    void add(const double *x, const double *y, double *out, const size_t n) {
+        kernels().add(x, y, out, n);
+    }
+
+    void sub(const double *x, const double *y, double *out, const size_t n) {
+        kernels().sub(x, y, out, n);
+    }
+
+    void mul(const double *x, const double *y, double *out, const size_t n) {
+        kernels().mul(x, y, out, n);
+    }
+
+    void scale(const double k, const double *x, double *out, const size_t n) {
+        kernels().scale(k, x, out, n);
+    }
+
+    const char *isa() {
+        return kernels().isa;
+    }
+}
@@ -0,0 +1,395 @@
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <lbd/error.h>
+#include <lbd/fe/serialize.h>
+#include <lbd/intp/builtins.h>
+#include <lbd/intp/snapshot.h>
+#include <lbd/utils/mapped_file.h>
+
+// Image layout:
+//   magic, FORMAT_VERSION, build id, loaded files, arenas,
+//   object counts (envs, thunks, lists), then env, thunk and list records.
+// Objects reference each other by index, which allows cycles (recursive bindings) and sharing (aliased lists).
+
+namespace intp::snapshot {
+    using fe::serialize::Reader;
+    using fe::serialize::Writer;
+
+    static constexpr char MAGIC[8] = {'L', 'B', 'D', 'I', 'M', 'G', '\0', '\0'};
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    enum class ValueTag : uint8_t { Float, String, Closure, Native, List, Stream, Dict };
+
+    enum ThunkFlags : uint8_t {
+        HAS_EXPR = 1 << 0,
+        OWNS_ARENA = 1 << 1,
+        HAS_ENV = 1 << 2,
+        HAS_CACHED = 1 << 3,
+        HAS_ORIGIN = 1 << 4,
+        GLOBAL = 1 << 5,
+    };
+
+    /// Assigns indices to every object reachable from the global Environment
+    struct Collector {
+        std::unordered_map<const interp::Env *, uint32_t> env_ids;
+        std::unordered_map<const interp::Thunk *, uint32_t> thunk_ids;
+        std::unordered_map<const interp::List *, uint32_t> list_ids;
+        std::unordered_map<const fe::ast::Arena *, uint32_t> arena_ids;
+        std::vector<const interp::Env *> envs;
+        std::vector<const interp::Thunk *> thunks;
+        std::vector<const interp::List *> lists;
+        std::vector<const fe::ast::Arena *> arenas; /// Every Arena referenced by a Thunk or Closure
+
+        void visit_arena(const fe::ast::Arena *arena) {
+            if (!arena || arena_ids.contains(arena)) return;
+            arena_ids[arena] = static_cast<uint32_t>(arenas.size());
+            arenas.push_back(arena);
+        }
+
+        void visit_env(const interp::Env *env) {
+            if (!env || env_ids.contains(env)) return;
+            env_ids[env] = static_cast<uint32_t>(envs.size());
+            envs.push_back(env);
+            visit_env(env->parent.get());
+            for (const auto &[_, thunk]: env->table) {
+                visit_thunk(thunk.get());
+            }
+        }
+
+        void visit_thunk(const interp::Thunk *thunk) {
+            if (thunk_ids.contains(thunk)) return;
+            thunk_ids[thunk] = static_cast<uint32_t>(thunks.size());
+            thunks.push_back(thunk);
+            visit_arena(thunk->arena);
+            visit_env(thunk->env.get());
+            if (thunk->cached) {
+                visit_value(*thunk->cached);
+            }
+        }
+
+        void visit_value(const interp::Value &value) {
+            if (const auto *closure = std::get_if<interp::Closure>(&value)) {
+                visit_arena(closure->arena);
+                visit_env(closure->env.get());
+            } else if (const auto *list = std::get_if<std::shared_ptr<interp::List> >(&value)) {
+                if (list_ids.contains(list->get())) return;
+                list_ids[list->get()] = static_cast<uint32_t>(lists.size());
+                lists.push_back(list->get());
+                // A numeric List holds no references
+                for (const auto &elem: (*list)->elements) {
+                    visit_value(elem);
+                }
+            } else if (const auto *stream = std::get_if<std::shared_ptr<interp::Stream> >(&value)) {
+                visit_value((*stream)->fn);
+                visit_value((*stream)->source);
+                visit_env((*stream)->env.get());
+            } else if (const auto *dict = std::get_if<std::shared_ptr<interp::Dict> >(&value)) {
+                (*dict)->entries.for_each([&](const interp::Value &, const interp::Value &elem) {
+                    visit_value(elem);
+                });
+            }
+        }
+    };
+
+    static options::Options options_v;
+
+    static void write_value(Writer &w, const interp::Value &value, const Collector &collector) {
+        std::visit([&]<typename T0>(T0 &&arg) {
+            using T = std::decay_t<T0>;
+            if constexpr (std::is_same_v<T, double>) {
+                w.u8(static_cast<uint8_t>(ValueTag::Float));
+                w.f64(arg);
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                w.u8(static_cast<uint8_t>(ValueTag::String));
+                w.str(arg);
+            } else if constexpr (std::is_same_v<T, std::shared_ptr<interp::Rope> >) {
+                // Every builtin taking a Rope also takes the String it spells, so it is restored as one
+                w.u8(static_cast<uint8_t>(ValueTag::String));
+                w.str(arg->flat());
+            } else if constexpr (std::is_same_v<T, interp::Closure>) {
+                w.u8(static_cast<uint8_t>(ValueTag::Closure));
+                w.str(arg.param);
+                w.u32(collector.arena_ids.at(arg.arena));
+                w.u32(arg.body);
+                w.u32(arg.env ? collector.env_ids.at(arg.env.get()) : NONE);
+            } else if constexpr (std::is_same_v<T, std::shared_ptr<interp::NativeFunction> >) {
+                w.u8(static_cast<uint8_t>(ValueTag::Native));
+                w.str(arg->name);
+            } else if constexpr (std::is_same_v<T, std::shared_ptr<interp::List> >) {
+                w.u8(static_cast<uint8_t>(ValueTag::List));
+                w.u32(collector.list_ids.at(arg.get()));
+            } else if constexpr (std::is_same_v<T, std::shared_ptr<interp::Stream> >) {
+                // Streams are immutable descriptions, shared ones are simply written once per reference
+                w.u8(static_cast<uint8_t>(ValueTag::Stream));
+                w.u8(static_cast<uint8_t>(arg->kind));
+                w.f64(arg->start);
+                w.f64(arg->end);
+                write_value(w, arg->fn, collector);
+                write_value(w, arg->source, collector);
+                w.u32(arg->env ? collector.env_ids.at(arg->env.get()) : NONE);
+            } else if constexpr (std::is_same_v<T, std::shared_ptr<interp::Dict> >) {
+                // Written inline like Streams, the node structure is rebuilt by reinserting on load
+                w.u8(static_cast<uint8_t>(ValueTag::Dict));
+                w.u32(static_cast<uint32_t>(arg->entries.size()));
+                arg->entries.for_each([&](const interp::Value &key, const interp::Value &elem) {
+                    write_value(w, key, collector);
+                    write_value(w, elem, collector);
+                });
+            } else {
+                STATIC_ASSERT_UNREACHABLE_T(T, "unhandled runtime value");
+            }
+        }, value);
+    }
+
+    void save(const std::string &filepath, const std::shared_ptr<interp::Env> &global_env,
+              const std::unordered_set<std::string> &loaded_files, options::Options options_) {
+        options_v = std::move(options_);
+        Collector collector;
+        collector.visit_env(global_env.get());
+
+        Writer w;
+        w.buffer.append(MAGIC, sizeof(MAGIC));
+        w.u32(fe::serialize::FORMAT_VERSION);
+        w.str(fe::serialize::build_id());
+        w.u32(static_cast<uint32_t>(loaded_files.size()));
+        for (const auto &file: loaded_files) {
+            w.str(file);
+        }
+        w.u32(static_cast<uint32_t>(collector.arenas.size()));
+        for (const auto *arena: collector.arenas) {
+            fe::serialize::write_arena(w, *arena);
+        }
+
+        w.u32(static_cast<uint32_t>(collector.envs.size()));
+        w.u32(static_cast<uint32_t>(collector.thunks.size()));
+        w.u32(static_cast<uint32_t>(collector.lists.size()));
+        for (const auto *env: collector.envs) {
+            w.u32(env->parent ? collector.env_ids.at(env->parent.get()) : NONE);
+            w.u32(static_cast<uint32_t>(env->table.size()));
+            for (const auto &[name, thunk]: env->table) {
+                w.str(name);
+                w.u32(collector.thunk_ids.at(thunk.get()));
+            }
+        }
+        for (const auto *thunk: collector.thunks) {
+            uint8_t flags = 0;
+            if (thunk->arena) flags |= HAS_EXPR;
+            if (thunk->owned) flags |= OWNS_ARENA;
+            if (thunk->env) flags |= HAS_ENV;
+            if (thunk->cached) flags |= HAS_CACHED;
+            if (thunk->origin) flags |= HAS_ORIGIN;
+            if (thunk->global) flags |= GLOBAL;
+            w.u8(flags);
+            if (thunk->arena) {
+                w.u32(collector.arena_ids.at(thunk->arena));
+                w.u32(thunk->expr);
+            }
+            if (thunk->env) w.u32(collector.env_ids.at(thunk->env.get()));
+            if (thunk->cached) write_value(w, *thunk->cached, collector);
+            if (thunk->origin) fe::serialize::write_loc(w, *thunk->origin);
+            if (thunk->global) {
+                // Only dependents still reachable from the global Environment are kept
+                std::vector<uint32_t> dependent_ids;
+                for (const auto &[dependent, _]: thunk->dependents) {
+                    if (const auto it = collector.thunk_ids.find(dependent); it != collector.thunk_ids.end()) {
+                        dependent_ids.push_back(it->second);
+                    }
+                }
+                w.u32(static_cast<uint32_t>(dependent_ids.size()));
+                for (const uint32_t id: dependent_ids) {
+                    w.u32(id);
+                }
+            }
+        }
+        for (const auto *list: collector.lists) {
+            w.u32(static_cast<uint32_t>(list->size()));
+            list->for_each([&](const interp::Value &elem) {
+                write_value(w, elem, collector);
+            });
+        }
+
+        std::ofstream ofs(filepath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!ofs) {
+            options_v.logger.error({}, "IO error: could not open file ", filepath);
+        }
+        ofs.write(w.buffer.data(), static_cast<std::streamsize>(w.buffer.size()));
+        if (!ofs) {
+            options_v.logger.error({}, "IO error: could not write file ", filepath);
+        }
+    }
+
+    /// Objects allocated up front so records can reference each other by index
+    struct Restorer {
+        std::vector<std::shared_ptr<fe::ast::Arena> > arenas;
+        std::vector<std::shared_ptr<interp::Env> > envs;
+        std::vector<std::shared_ptr<interp::Thunk> > thunks;
+        std::vector<std::shared_ptr<interp::List> > lists;
+        std::unordered_map<std::string, std::shared_ptr<interp::NativeFunction> > natives;
+
+        template<typename T>
+        const T &at(const std::vector<T> &items, const uint32_t id) const {
+            if (id >= items.size()) {
+                options_v.logger.error({}, "IO error: corrupt image, object index ", id, " out of range");
+            }
+            return items[id];
+        }
+
+        std::pair<std::shared_ptr<fe::ast::Arena>, fe::ast::ExprId> read_expr(Reader &r) const {
+            const auto &arena = at(arenas, r.u32());
+            const fe::ast::ExprId expr = r.u32();
+            if (expr >= arena->exprs.size()) {
+                options_v.logger.error({}, "IO error: corrupt image, expression index ", expr, " out of range");
+            }
+            return {arena, expr};
+        }
+
+        interp::Value read_value(Reader &r) const {
+            switch (static_cast<ValueTag>(r.u8())) {
+                case ValueTag::Float:
+                    return interp::Value{r.f64()};
+                case ValueTag::String:
+                    return interp::Value{r.str()};
+                case ValueTag::Closure: {
+                    std::string param = r.str();
+                    const auto [arena, body] = read_expr(r);
+                    const uint32_t env_id = r.u32();
+                    return interp::Value{
+                        interp::Closure{
+                            std::move(param), arena.get(), body, env_id == NONE ? nullptr : at(envs, env_id)
+                        }
+                    };
+                }
+                case ValueTag::Native: {
+                    const std::string name = r.str();
+                    const auto it = natives.find(name);
+                    if (it == natives.end()) {
+                        options_v.logger.error({}, "IO error: image references unknown native function ", name);
+                    }
+                    return interp::Value{it->second};
+                }
+                case ValueTag::List:
+                    return interp::Value{at(lists, r.u32())};
+                case ValueTag::Stream: {
+                    const uint8_t kind = r.u8();
+                    if (kind > static_cast<uint8_t>(interp::Stream::Kind::Zip)) {
+                        options_v.logger.error({}, "IO error: corrupt stream kind at offset ", r.pos - 1);
+                    }
+                    auto stream = std::make_shared<interp::Stream>();
+                    stream->kind = static_cast<interp::Stream::Kind>(kind);
+                    stream->start = r.f64();
+                    stream->end = r.f64();
+                    stream->fn = read_value(r);
+                    stream->source = read_value(r);
+                    const uint32_t env_id = r.u32();
+                    stream->env = env_id == NONE ? nullptr : at(envs, env_id);
+                    return interp::Value{std::move(stream)};
+                }
+                case ValueTag::Dict: {
+                    auto dict = std::make_shared<interp::Dict>();
+                    const uint32_t count = r.u32();
+                    for (uint32_t i = 0; i < count; ++i) {
+                        interp::Value key = read_value(r);
+                        interp::Value elem = read_value(r);
+                        dict->entries = dict->entries.insert(std::move(key), std::move(elem));
+                    }
+                    return interp::Value{std::move(dict)};
+                }
+                default:
+                    options_v.logger.error({}, "IO error: corrupt value tag at offset ", r.pos - 1);
+            }
+        }
+    };
+
+    Image load(const std::string &filepath, options::Options options_) {
+        options_v = std::move(options_);
+        const MappedFile file(filepath);
+        if (file.error) {
+            options_v.logger.error({}, "IO error: ", file.error, " ", filepath);
+        }
+        Reader r(file.data, file.size, options_v);
+        if (file.size < sizeof(MAGIC) || std::memcmp(file.data, MAGIC, sizeof(MAGIC)) != 0) {
+            options_v.logger.error({}, "IO error: ", filepath, " is not an lbd image");
+        }
+        r.pos = sizeof(MAGIC);
+        if (const uint32_t version = r.u32(); version != fe::serialize::FORMAT_VERSION) {
+            options_v.logger.error({}, "IO error: image format version ", version, " does not match ",
+                                   fe::serialize::FORMAT_VERSION);
+        }
+        if (const std::string build = r.str(); build != fe::serialize::build_id()) {
+            options_v.logger.error({}, "IO error: image was written by interpreter build ", build, ", this is ",
+                                   fe::serialize::build_id());
+        }
+
+        Image image;
+        const uint32_t file_count = r.u32();
+        for (uint32_t i = 0; i < file_count; ++i) {
+            image.loaded_files.insert(r.str());
+        }
+        Restorer restorer;
+        restorer.arenas.resize(r.u32());
+        for (auto &arena: restorer.arenas) {
+            arena = std::make_shared<fe::ast::Arena>(fe::serialize::read_arena(r));
+        }
+        for (auto &native_fn: interp::builtins::get_builtins(options_v)) {
+            std::string name = native_fn.name;
+            restorer.natives.emplace(std::move(name), std::make_shared<interp::NativeFunction>(std::move(native_fn)));
+        }
+        restorer.envs.resize(r.u32());
+        restorer.thunks.resize(r.u32());
+        restorer.lists.resize(r.u32());
+        for (auto &env: restorer.envs) env = std::make_shared<interp::Env>();
+        for (auto &thunk: restorer.thunks) thunk = std::make_shared<interp::Thunk>();
+        for (auto &list: restorer.lists) list = std::make_shared<interp::List>();
+
+        for (const auto &env: restorer.envs) {
+            if (const uint32_t parent_id = r.u32(); parent_id != NONE) {
+                env->parent = restorer.at(restorer.envs, parent_id);
+            }
+            const uint32_t binding_count = r.u32();
+            env->table.reserve(binding_count);
+            for (uint32_t i = 0; i < binding_count; ++i) {
+                std::string name = r.str();
+                env->bind(name, restorer.at(restorer.thunks, r.u32()));
+            }
+        }
+        for (const auto &thunk: restorer.thunks) {
+            const uint8_t flags = r.u8();
+            if (flags & HAS_EXPR) {
+                auto [arena, expr] = restorer.read_expr(r);
+                thunk->arena = arena.get();
+                thunk->expr = expr;
+                if (flags & OWNS_ARENA) {
+                    thunk->owned = std::move(arena);
+                }
+            }
+            if (flags & HAS_ENV) thunk->env = restorer.at(restorer.envs, r.u32());
+            if (flags & HAS_CACHED) thunk->cached = restorer.read_value(r);
+            if (flags & HAS_ORIGIN) thunk->origin = fe::serialize::read_loc(r);
+            if (flags & GLOBAL) {
+                thunk->global = true;
+                const uint32_t n = r.u32();
+                for (uint32_t i = 0; i < n; ++i) {
+                    const auto &dependent = restorer.at(restorer.thunks, r.u32());
+                    thunk->dependents.emplace(dependent.get(), dependent);
+                }
+            }
+        }
+        for (const auto &list: restorer.lists) {
+            const uint32_t n = r.u32();
+            std::vector<interp::Value> elements;
+            elements.reserve(n);
+            for (uint32_t i = 0; i < n; ++i) {
+                elements.push_back(restorer.read_value(r));
+            }
+            *list = interp::List(std::move(elements));
+        }
+        // The global Environment is always the first one visited
+        if (restorer.envs.empty()) {
+            options_v.logger.error({}, "IO error: image has no global environment");
+        }
+        image.global_env = restorer.envs.front();
+        image.arenas.assign(restorer.arenas.begin(), restorer.arenas.end());
+        return image;
+    }
+}
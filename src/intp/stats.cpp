@@ -0,0 +1,120 @@
+#include <iomanip>
+#include <mutex>
+#include <lbd/intp/stats.h>
+
+namespace intp::stats {
+    /// Per-name call counters, map nodes never move so NativeFunctions can keep pointers to them
+    static std::mutex native_counters_mutex;
+    static std::map<std::string, std::atomic<uint64_t>, std::less<> > native_counters;
+
+    std::atomic<uint64_t> *native_counter(const std::string_view name) {
+        if (!compiled_in) {
+            return nullptr;
+        }
+        std::lock_guard lock(native_counters_mutex);
+        auto it = native_counters.find(name);
+        if (it == native_counters.end()) {
+            it = native_counters.try_emplace(std::string(name)).first;
+        }
+        return &it->second;
+    }
+
+    Snapshot snapshot() {
+        std::map<std::string, uint64_t> native_calls_by_name;
+        {
+            std::lock_guard lock(native_counters_mutex);
+            for (const auto &[name, calls]: native_counters) {
+                if (const uint64_t n = calls.load(std::memory_order_relaxed)) {
+                    native_calls_by_name.emplace(name, n);
+                }
+            }
+        }
+        return {
+            counters.thunks_created.load(), counters.thunks_forced.load(), counters.thunk_cache_hits.load(),
+            counters.env_frames.load(), counters.closure_applications.load(), counters.native_calls.load(),
+            std::move(native_calls_by_name), counters.peak_depth.load(), counters.allocations.load(),
+            counters.bytes_allocated.load()
+        };
+    }
+
+    void reset() {
+        counters.thunks_created = 0;
+        counters.thunks_forced = 0;
+        counters.thunk_cache_hits = 0;
+        counters.env_frames = 0;
+        counters.closure_applications = 0;
+        counters.native_calls = 0;
+        {
+            std::lock_guard lock(native_counters_mutex);
+            for (auto &[_, calls]: native_counters) {
+                calls = 0;
+            }
+        }
+        counters.peak_depth = depth;
+        counters.allocations = 0;
+        counters.bytes_allocated = 0;
+    }
+
+    void report(std::ostream &os) {
+        if (!compiled_in) {
+            os << "stats: compiled out (LBD_DISABLE_STATS)" << std::endl;
+            return;
+        }
+        const Snapshot s = snapshot();
+        const auto row = [&](const std::string &label, const uint64_t value) {
+            os << "  " << std::left << std::setw(24) << label << std::right << std::setw(14) << value << std::endl;
+        };
+        os << "stats:" << std::endl;
+        row("thunks created", s.thunks_created);
+        row("thunks forced", s.thunks_forced);
+        row("thunk cache hits", s.thunk_cache_hits);
+        row("env frames", s.env_frames);
+        row("closure applications", s.closure_applications);
+        row("native calls", s.native_calls);
+        row("peak depth", s.peak_depth);
+        row("allocations", s.allocations);
+        row("bytes allocated", s.bytes_allocated);
+        for (const auto &[name, calls]: s.native_calls_by_name) {
+            row("  " + name, calls);
+        }
+    }
+
+    static void write_json_string(std::ostream &os, const std::string &value) {
+        os << '"';
+        for (const char c: value) {
+            if (c == '"' || c == '\\') {
+                os << '\\' << c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                        << std::dec << std::setfill(' ');
+            } else {
+                os << c;
+            }
+        }
+        os << '"';
+    }
+
+    void write_json(std::ostream &os) {
+        const Snapshot s = snapshot();
+        os << "{\n"
+                << "  \"enabled\": " << (compiled_in ? "true" : "false") << ",\n"
+                << "  \"thunks_created\": " << s.thunks_created << ",\n"
+                << "  \"thunks_forced\": " << s.thunks_forced << ",\n"
+                << "  \"thunk_cache_hits\": " << s.thunk_cache_hits << ",\n"
+                << "  \"env_frames\": " << s.env_frames << ",\n"
+                << "  \"closure_applications\": " << s.closure_applications << ",\n"
+                << "  \"native_calls\": " << s.native_calls << ",\n"
+                << "  \"peak_depth\": " << s.peak_depth << ",\n"
+                << "  \"allocations\": " << s.allocations << ",\n"
+                << "  \"bytes_allocated\": " << s.bytes_allocated << ",\n"
+                << "  \"native_calls_by_name\": {";
+        bool first = true;
+        for (const auto &[name, calls]: s.native_calls_by_name) {
+            os << (first ? "\n    " : ",\n    ");
+            write_json_string(os, name);
+            os << ": " << calls;
+            first = false;
+        }
+        os << (first ? "}\n" : "\n  }\n") << "}" << std::endl;
+    }
+}
@@ -1,39 +1,132 @@
-﻿#include <iostream>
+﻿#include <fstream>
+#include <iostream>
 #include <lbd/fe/ast.h>
 #include <lbd/fe/lexer.h>
 #include <lbd/fe/parser.h>
+#include <lbd/fe/trace.h>
+#include <lbd/intp/heap_profile.h>
 #include <lbd/intp/interpreter.h>
+#include <lbd/intp/profiler.h>
+#include <lbd/intp/snapshot.h>
+#include <lbd/intp/stats.h>
 #include <lbd/cmd.h>
 #include <lbd/repl.h>
+#include <lbd/serve.h>
 #include <string>
 #include <vector>
 
 const std::string &program_name = "lbd";
 
+static int write_stats(const cmd::Options &opts) {
+    if (opts.stats) {
+        std::cerr << std::endl;
+        intp::stats::report(std::cerr);
+    }
+    if (opts.stats_json_path) {
+        std::ofstream ofs(*opts.stats_json_path);
+        if (!ofs) {
+            std::cerr << "error: could not write stats to " << *opts.stats_json_path << std::endl;
+            return EXIT_FAILURE;
+        }
+        intp::stats::write_json(ofs);
+    }
+    return EXIT_SUCCESS;
+}
+
+static int write_heap_profile(const cmd::Options &opts, const std::shared_ptr<intp::interp::Env> &global_env) {
+    if (!opts.heap_profile_path) {
+        return EXIT_SUCCESS;
+    }
+    std::ofstream ofs(*opts.heap_profile_path);
+    if (!ofs) {
+        std::cerr << "error: could not write heap profile to " << *opts.heap_profile_path << std::endl;
+        return EXIT_FAILURE;
+    }
+    intp::heap::write(ofs);
+    std::cerr << std::endl;
+    intp::heap::report(std::cerr, global_env, 20);
+    return EXIT_SUCCESS;
+}
+
 int main(const int argc, char **argv) {
-    const auto &[filepath, show_help, repl, debug] = cmd::parse_args(argc, argv, program_name);
-    if (show_help) {
+    const cmd::Options opts = cmd::parse_args(argc, argv, program_name);
+    const bool debug = opts.debug;
+    if (opts.show_help) {
         cmd::print_help(std::cout, argv[0]);
         return EXIT_SUCCESS;
     }
-    if (repl) {
-        repl::loop(debug);
+    if (opts.serve_socket) {
+        return serve::run(*opts.serve_socket, opts.filepath, debug);
+    }
+    options::Options options_v;
+    options_v.module_cache = !opts.no_cache;
+    options_v.fuse_maps = opts.fuse;
+    // Restore heap snapshot, the image owns the AST its Thunks point into
+    intp::snapshot::Image image;
+    std::optional<std::shared_ptr<intp::interp::Env> > global_env = std::nullopt;
+    if (opts.image_path) {
+        image = intp::snapshot::load(*opts.image_path);
+        global_env = image.global_env;
+        fe::parser::loaded_files() = image.loaded_files;
+    }
+    if (opts.heap_profile_path) {
+        intp::heap::start();
+    }
+    if (opts.repl) {
+        repl::loop(debug, image.global_env);
+        if (write_heap_profile(opts, nullptr) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        return write_stats(opts);
     } else {
-        // Lex
-        auto lexer_v = fe::lexer::Lexer(*filepath, fe::lexer::FromFile{});
-        const std::vector<fe::token::Token> tokens = lexer_v.lex_all();
-        if (debug) {
-            for (const fe::token::Token &token: tokens) {
-                std::cout << token << std::endl;
-            }
+        if (opts.trace_path) {
+            fe::trace::start();
         }
-        // Parse
-        auto parser = fe::parser::Parser(tokens);
+        // Lex and Parse, tokens are pulled on demand and logged as they are consumed in debug mode
+        options::Options lexer_options = options_v;
+        lexer_options.debug = debug;
+        auto lexer_v = [&] {
+            fe::trace::Span span("lex");
+            if (span) {
+                span.name = "open " + *opts.filepath;
+            }
+            return fe::lexer::Lexer(*opts.filepath, fe::lexer::FromFile{}, lexer_options);
+        }();
+        auto parser = fe::parser::Parser(lexer_v, options_v);
         if (debug) {
             std::cout << parser.program << std::endl;
         }
         // Interpret
-        auto result = intp::interp::interpret(parser.program);
-        return EXIT_SUCCESS;
+        if (opts.profile_path) {
+            intp::profiler::start();
+        }
+        auto result = intp::interp::interpret(parser.program, global_env, options_v);
+        if (opts.profile_path) {
+            intp::profiler::stop();
+            std::ofstream ofs(*opts.profile_path);
+            if (!ofs) {
+                std::cerr << "error: could not write profile to " << *opts.profile_path << std::endl;
+                return EXIT_FAILURE;
+            }
+            intp::profiler::write_collapsed(ofs);
+            std::cerr << std::endl;
+            intp::profiler::report(std::cerr, 20);
+        }
+        if (opts.trace_path) {
+            fe::trace::stop();
+            std::ofstream ofs(*opts.trace_path);
+            if (!ofs) {
+                std::cerr << "error: could not write trace to " << *opts.trace_path << std::endl;
+                return EXIT_FAILURE;
+            }
+            fe::trace::write(ofs);
+        }
+        if (write_heap_profile(opts, result.global_env) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        if (opts.snapshot_path) {
+            intp::snapshot::save(*opts.snapshot_path, result.global_env, fe::parser::loaded_files());
+        }
+        return write_stats(opts);
     }
 }
@@ -1,11 +1,16 @@
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <lbd/repl.h>
 #include <lbd/utils/term.h>
 #include <lbd/fe/lexer.h>
+#include <lbd/fe/loc.h>
 #include <lbd/fe/parser.h>
+#include <lbd/intp/heap_profile.h>
 #include <lbd/intp/interpreter.h>
+#include <lbd/intp/profiler.h>
+#include <lbd/intp/stats.h>
 #include <lbd/exceptions.h>
 
 #define on_off(val) ((val) ? "on " : "off")
@@ -26,18 +31,9 @@ namespace repl {
         }
 
         fe::lexer::Lexer lexer(filepath, fe::lexer::FromFile{}, sub_options);
-        const auto tokens = lexer.lex_all();
+        fe::parser::Parser parser(lexer, sub_options);
         if (sub_options.debug) {
-            for (const auto &tok: tokens) {
-                sub_options.logger.debug(tok);
-            }
-        }
-
-        fe::parser::Parser parser(tokens, sub_options);
-        if (sub_options.debug) {
-            for (const auto &node: parser.program.nodes) {
-                sub_options.logger.debug(node);
-            }
+            sub_options.logger.debug(parser.program);
         }
 
         const std::optional<std::shared_ptr<intp::interp::Env> > temp_env = shared_env;
@@ -61,6 +57,48 @@ namespace repl {
         sub_options.logger.info("info: file loaded ", filepath);
     }
 
+    static void process_line(const std::string &line,
+                             std::optional<std::shared_ptr<intp::interp::Env> > &shared_env) {
+        fe::loc::EphemeralFiles line_files;
+        // Lex and Parse
+        fe::lexer::Lexer lexer_v(line, fe::lexer::FromRepl{}, options_v);
+        fe::parser::Parser parser_v(lexer_v, options_v);
+        // Definitions keep their AST, and the Locs in it, alive in the global Env
+        if (std::ranges::any_of(parser_v.program.nodes, [](const fe::ast::AstNode &node) {
+            return std::holds_alternative<fe::ast::DefAstNode>(node.value);
+        })) {
+            line_files.keep();
+        }
+        if (options_v.debug) {
+            options_v.logger.debug(parser_v.program);
+        }
+
+        // Interpret
+        const auto [global_env, value, result_options] = intp::interp::interpret(
+            parser_v.program, shared_env, options_v);
+        if (result_options.side_effects) {
+            std::cout << std::endl;
+        }
+        std::cout << colors::GREEN << "=> " << value << colors::RESET << std::endl;
+        shared_env = global_env;
+    }
+
+    static void process_profile_command(const std::string &arg,
+                                        std::optional<std::shared_ptr<intp::interp::Env> > &shared_env) {
+        // The report below still prints locations in the profiled input
+        const fe::loc::EphemeralFiles profiled_files;
+        intp::profiler::start();
+        try {
+            process_line(arg, shared_env);
+        } catch (...) {
+            intp::profiler::stop();
+            throw;
+        }
+        intp::profiler::stop();
+        std::cout << std::endl;
+        intp::profiler::report(std::cout, 20);
+    }
+
     static int compute_paren_depth(const std::string &s) {
         int depth = 0;
         for (const char c: s) {
@@ -78,15 +116,20 @@ namespace repl {
         return s.substr(start, end - start);
     }
 
-    void loop(const bool debug) {
+    void loop(const bool debug, std::shared_ptr<intp::interp::Env> initial_env) {
         enable_virtual_terminal();
 
         static logs::Logger logger(false, true, false);
-        options_v = {.own_expr = true, .force_on_env_dump = false, .debug = debug, .logger = logger};
+        options_v = {
+            .own_expr = true, .force_on_env_dump = false, .debug = debug, .logger = logger, .track_dependencies = true
+        };
 
         std::string line, buffer;
         size_t indent_level = 0;
         std::optional<std::shared_ptr<intp::interp::Env> > shared_global_env = std::nullopt;
+        if (initial_env) {
+            shared_global_env = std::move(initial_env);
+        }
 
         options_v.logger.info("Welcome to lambda-discipline REPL.\nType :quit to exit.");
 
@@ -131,7 +174,10 @@ namespace repl {
                         std::cout << std::endl;
                         print_table({"Inspection Commands", "Argument", "Description"}, {
                                         {":e, :env", "", "Dump environment bindings"},
-                                        {":force", "", "Force thunk evaluation on dump"}
+                                        {":force", "", "Force thunk evaluation on dump"},
+                                        {":profile", "<expr>", "Evaluate with profiling and show the hottest sites"},
+                                        {":stats", "[reset]", "Show or reset interpreter operation counters"},
+                                        {":heap", "[off]", "Start heap tracking or show live objects by site"}
                                     }, colors::GREEN);
                         std::cout << std::endl;
                         print_table({"Options", "State", "Help"}, {
@@ -180,6 +226,38 @@ namespace repl {
                         process_load_command(line.substr(3), shared_global_env);
                         continue;
                     }
+
+                    if (line == ":stats") {
+                        std::cout << std::endl;
+                        intp::stats::report(std::cout);
+                        continue;
+                    }
+
+                    if (line == ":heap") {
+                        if (!intp::heap::enabled) {
+                            intp::heap::start();
+                            options_v.logger.info("info: heap tracking on, objects created from now on are tracked");
+                        } else {
+                            std::cout << std::endl;
+                            intp::heap::report(std::cout, shared_global_env.value_or(nullptr));
+                        }
+                        continue;
+                    }
+
+                    if (line == ":heap off") {
+                        intp::heap::stop();
+                        continue;
+                    }
+
+                    if (line == ":stats reset") {
+                        intp::stats::reset();
+                        continue;
+                    }
+
+                    if (line.rfind(":profile ", 0) == 0) {
+                        process_profile_command(line.substr(9), shared_global_env);
+                        continue;
+                    }
                 }
 
                 if (line.empty()) continue;
@@ -204,29 +282,7 @@ namespace repl {
                 line = buffer;
                 buffer.clear();
 
-                // Lex
-                fe::lexer::Lexer lexer_v(line, fe::lexer::FromRepl{}, options_v);
-                const std::vector<fe::token::Token> tokens = lexer_v.lex_all();
-                if (options_v.debug) {
-                    for (const auto &tok: tokens) {
-                        options_v.logger.debug(tok);
-                    }
-                }
-
-                // Parse
-                fe::parser::Parser parser_v(tokens, options_v);
-                if (options_v.debug) {
-                    options_v.logger.debug(parser_v.program);
-                }
-
-                // Interpret
-                const auto [global_env, value, result_options] = intp::interp::interpret(
-                    parser_v.program, shared_global_env, options_v);
-                if (result_options.side_effects) {
-                    std::cout << std::endl;
-                }
-                std::cout << colors::GREEN << "=> " << value << colors::RESET << std::endl;
-                shared_global_env = global_env;
+                process_line(line, shared_global_env);
             } catch (const ControlledExit &) {
             } catch (const std::exception &ex) {
                 options_v.logger.error({}, "error: ", ex.what());
@@ -0,0 +1,176 @@
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <unordered_set>
+#include <lbd/serve.h>
+#include <lbd/exceptions.h>
+#include <lbd/fe/lexer.h>
+#include <lbd/fe/loc.h>
+#include <lbd/fe/parser.h>
+#include <lbd/intp/cow.h>
+#include <lbd/intp/interpreter.h>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+namespace serve {
+#if defined(_WIN32)
+    int run(const std::string &, const std::optional<std::string> &, bool) {
+        std::cerr << "error: --serve requires Unix domain sockets, which are not supported on this platform"
+                << std::endl;
+        return EXIT_FAILURE;
+    }
+#else
+    static options::Options options_v;
+
+    /// Removes a socket left at path by an earlier server. Anything else at path is left alone,
+    /// returns false when path exists and is not a socket.
+    static bool remove_stale_socket(const std::string &path) {
+        struct stat info{};
+        if (::lstat(path.c_str(), &info) < 0) {
+            return errno == ENOENT;
+        }
+        if (!S_ISSOCK(info.st_mode)) {
+            return false;
+        }
+        ::unlink(path.c_str());
+        return true;
+    }
+
+    /// Warm state shared by every request
+    struct Prelude {
+        fe::ast::Program program; /// Kept alive, global Thunks point into its AST
+        std::shared_ptr<intp::interp::Env> global_env;
+        std::unordered_set<std::string> loaded_files;
+    };
+
+    static Prelude load_prelude(const std::optional<std::string> &filepath) {
+        Prelude prelude;
+        if (filepath) {
+            if (!std::filesystem::exists(*filepath)) {
+                options_v.logger.error({}, "IO error: filepath ", *filepath, " does not exist");
+            }
+            fe::lexer::Lexer lexer_v(*filepath, fe::lexer::FromFile{}, options_v);
+            fe::parser::Parser parser_v(lexer_v, options_v);
+            prelude.program = std::move(parser_v.program);
+        }
+        prelude.global_env = intp::interp::interpret(prelude.program, std::nullopt, options_v).global_env;
+        prelude.loaded_files = fe::parser::loaded_files();
+        // Requests share the prelude heap, changes they make to it are undone after each of them
+        intp::cow::freeze(prelude.global_env);
+        return prelude;
+    }
+
+    /// Evaluate a single request against a child of the warm global Environment.
+    /// Bindings made by the request land in the child and are dropped with it, changes it made to
+    /// prelude Lists are rolled back.
+    static std::string handle_request(const Prelude &prelude, const std::string &request) {
+        // Nothing parsed for the request outlives it, its source files are released afterwards
+        const fe::loc::EphemeralFiles request_files;
+        std::ostringstream output;
+        std::streambuf *cout_buf = std::cout.rdbuf(output.rdbuf());
+        std::streambuf *cerr_buf = std::cerr.rdbuf(output.rdbuf());
+        // Files pulled in by earlier requests are not part of the warm state
+        fe::parser::loaded_files() = prelude.loaded_files;
+        char status = STATUS_OK;
+        try {
+            if (request.empty()) {
+                options_v.logger.error({}, "request error: empty request");
+            }
+            const char kind = request.front();
+            std::string payload = request.substr(1);
+            std::optional<fe::lexer::Lexer> lexer_v;
+            if (kind == REQUEST_EXPR) {
+                lexer_v.emplace(std::move(payload), fe::lexer::FromRepl{}, options_v);
+            } else if (kind == REQUEST_FILE) {
+                if (!std::filesystem::exists(payload)) {
+                    options_v.logger.error({}, "IO error: filepath ", payload, " does not exist");
+                }
+                lexer_v.emplace(payload, fe::lexer::FromFile{}, options_v);
+            } else {
+                options_v.logger.error({}, "request error: unknown request kind ", kind);
+            }
+            fe::parser::Parser parser_v(*lexer_v, options_v);
+            const auto request_env = std::make_shared<intp::interp::Env>(prelude.global_env);
+            const auto [_, value, result_options] = intp::interp::interpret(parser_v.program, request_env, options_v);
+            if (kind == REQUEST_EXPR) {
+                if (result_options.side_effects) {
+                    output << std::endl;
+                }
+                output << "=> " << value << std::endl;
+            }
+        } catch (const ControlledExit &) {
+            status = STATUS_ERROR;
+        } catch (const std::exception &ex) {
+            output << "error: " << ex.what() << std::endl;
+            status = STATUS_ERROR;
+        }
+        intp::cow::thaw();
+        std::cout.rdbuf(cout_buf);
+        std::cerr.rdbuf(cerr_buf);
+        return status + output.str();
+    }
+
+    int run(const std::string &socket_path, const std::optional<std::string> &prelude_path, const bool debug) {
+        options_v = {
+            .own_expr = false, .force_on_env_dump = false, .debug = false, .logger = logs::Logger(false, false, true)
+        };
+        std::signal(SIGPIPE, SIG_IGN);
+
+        const Prelude prelude = [&] {
+            try {
+                return load_prelude(prelude_path);
+            } catch (const ControlledExit &) {
+                std::exit(EXIT_FAILURE);
+            }
+        }();
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "error: socket path too long " << socket_path << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::copy(socket_path.begin(), socket_path.end(), addr.sun_path);
+
+        const int server_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server_fd < 0) {
+            std::perror("socket");
+            return EXIT_FAILURE;
+        }
+        if (!remove_stale_socket(socket_path)) {
+            std::cerr << "error: refusing to serve on " << socket_path << ", it exists and is not a socket" << std::endl;
+            ::close(server_fd);
+            return EXIT_FAILURE;
+        }
+        if (::bind(server_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || ::listen(server_fd, 64) < 0) {
+            std::perror("bind");
+            ::close(server_fd);
+            return EXIT_FAILURE;
+        }
+        options_v.logger.info("info: serving on ", socket_path);
+
+        while (true) {
+            const int client_fd = ::accept(server_fd, nullptr, nullptr);
+            if (client_fd < 0) {
+                if (errno == EINTR) continue;
+                std::perror("accept");
+                break;
+            }
+            const std::string request = read_all(client_fd);
+            if (debug) {
+                options_v.logger.debug("debug: request ", request);
+            }
+            write_all(client_fd, handle_request(prelude, request));
+            ::close(client_fd);
+        }
+        ::close(server_fd);
+        remove_stale_socket(socket_path);
+        return EXIT_FAILURE;
+    }
+#endif
+}
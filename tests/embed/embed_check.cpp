@@ -0,0 +1,71 @@
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <variant>
+#include <lbd/embed/module.h>
+#include <lbd/exceptions.h>
+
+/// Loads a program through the embed library and calls into it the way a host application would.
+///
+/// usage: lbd_embed_check <script>
+///
+/// The script must define fibonacci, twice_plus (which calls the Native Function `twice` registered
+/// by the host) and total.
+
+static bool check(const std::string &what, const intp::interp::Value &actual, const double expected) {
+    const auto *value = std::get_if<double>(&actual);
+    if (!value || *value != expected) {
+        std::cerr << "FAILED " << what << ": expected " << expected << " got " << actual << std::endl;
+        return false;
+    }
+    std::cout << "ok " << what << std::endl;
+    return true;
+}
+
+int main(const int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <script>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        embed::Module module;
+        module.register_native({
+            1, "twice", [](const auto &args, const auto &) {
+                return std::make_pair(intp::interp::Value{2 * std::get<double>(args[0]->force())},
+                                      intp::interp::ResultOptions{});
+            }
+        });
+        module.load_file(argv[1]);
+
+        bool ok = true;
+        const embed::Function fibonacci = module.function("fibonacci");
+        ok = check("fibonacci 10", fibonacci(10.0), 55) && ok;
+        // A resolved handle is reusable across calls
+        ok = check("fibonacci 20", fibonacci(20.0), 6765) && ok;
+        ok = check("twice_plus 4 1", module.call("twice_plus", 4.0, 1.0), 9) && ok;
+        constexpr std::array<double, 4> xs = {1, 2, 3, 4};
+        ok = check("total [1, 2, 3, 4]", module.call("total", std::span<const double>(xs)), 10) && ok;
+
+        // Source loaded later sees the bindings of earlier Programs
+        module.load_source("fib_twice: Any = \\n: Float. (twice (fibonacci n))\n");
+        ok = check("fib_twice 10", module.call("fib_twice", 10.0), 110) && ok;
+
+        // Errors surface as ControlledExit and leave the Module usable
+        bool raised = false;
+        try {
+            (void) module.get("undefined_binding");
+        } catch (const ControlledExit &) {
+            raised = true;
+        }
+        if (!raised) {
+            std::cerr << "FAILED lookup of an undefined binding did not raise ControlledExit" << std::endl;
+            ok = false;
+        }
+        ok = check("fibonacci 10 after an error", fibonacci(10.0), 55) && ok;
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const ControlledExit &) {
+        std::cerr << "FAILED the script raised an error" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,117 @@
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <lbd/fe/lexer.h>
+#include <lbd/fe/parser.h>
+#include <lbd/intp/interpreter.h>
+#include <lbd/intp/stats.h>
+
+/// Runs one lbd script and checks its interpreter operation counts against a checked-in budget.
+/// Counts are deterministic, unlike wall-clock time, so any excess is a real regression.
+///
+/// usage: lbd_perf_check <script> <budget> [--update]
+///
+/// A budget file holds `<counter> <max>` lines, `#` starts a comment. --update rewrites the
+/// budget from the current counts with 5% headroom.
+
+static constexpr int SKIP_RETURN_CODE = 77;
+
+static uint64_t counter_value(const intp::stats::Snapshot &s, const std::string &counter) {
+    const std::vector<std::pair<std::string, uint64_t> > values = {
+        {"thunks_created", s.thunks_created},
+        {"thunks_forced", s.thunks_forced},
+        {"thunk_cache_hits", s.thunk_cache_hits},
+        {"env_frames", s.env_frames},
+        {"closure_applications", s.closure_applications},
+        {"native_calls", s.native_calls},
+        {"peak_depth", s.peak_depth},
+        {"allocations", s.allocations},
+        {"bytes_allocated", s.bytes_allocated},
+    };
+    for (const auto &[name, value]: values) {
+        if (name == counter) {
+            return value;
+        }
+    }
+    std::cerr << "error: unknown counter " << counter << std::endl;
+    std::exit(EXIT_FAILURE);
+}
+
+static std::vector<std::pair<std::string, uint64_t> > read_budget(const std::string &path) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        std::cerr << "error: could not read budget " << path << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    std::vector<std::pair<std::string, uint64_t> > budget;
+    std::string line;
+    while (std::getline(ifs, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream iss(line);
+        std::string counter;
+        uint64_t max;
+        if (iss >> counter >> max) {
+            budget.emplace_back(counter, max);
+        }
+    }
+    return budget;
+}
+
+static intp::stats::Snapshot run_script(const std::string &filepath) {
+    options::Options options_v;
+    options_v.logger = logs::Logger(true, false, true);
+    // Cache hits and misses allocate differently, always parse for stable counts
+    options_v.module_cache = false;
+    intp::stats::reset();
+    {
+        fe::lexer::Lexer lexer_v(filepath, fe::lexer::FromFile{}, options_v);
+        fe::parser::Parser parser(lexer_v, options_v);
+        intp::interp::interpret(parser.program, std::nullopt, options_v);
+    }
+    return intp::stats::snapshot();
+}
+
+int main(const int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <script> <budget> [--update]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::string script = argv[1];
+    const std::string budget_path = argv[2];
+    const bool update = argc > 3 && std::string(argv[3]) == "--update";
+    if (!intp::stats::compiled_in) {
+        std::cout << "skipped: stats are compiled out of this build" << std::endl;
+        return SKIP_RETURN_CODE;
+    }
+
+    auto budget = read_budget(budget_path);
+    const intp::stats::Snapshot actual = run_script(script);
+    std::cout << std::endl;
+
+    if (update) {
+        std::ofstream ofs(budget_path);
+        ofs << "# Operation budget for " << script << ", regenerate with lbd_perf_check --update\n";
+        for (const auto &[counter, _]: budget) {
+            const uint64_t value = counter_value(actual, counter);
+            ofs << counter << " " << value + value / 20 << "\n";
+        }
+        std::cout << "updated " << budget_path << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    bool ok = true;
+    std::cout << std::left << std::setw(24) << "counter" << std::right << std::setw(14) << "actual"
+            << std::setw(14) << "budget" << std::endl;
+    for (const auto &[counter, max]: budget) {
+        const uint64_t value = counter_value(actual, counter);
+        ok = ok && value <= max;
+        std::cout << std::left << std::setw(24) << counter << std::right << std::setw(14) << value
+                << std::setw(14) << max << (value > max ? "  OVER BUDGET" : "") << std::endl;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,17 @@
+# Runs LBD with ARGS on SCRIPT and compares everything it prints with the EXPECTED file,
+# or, when ERROR is set, checks that what it prints matches that regular expression.
+execute_process(
+    COMMAND ${LBD} ${ARGS} -f ${SCRIPT}
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+)
+if(DEFINED ERROR)
+    if(NOT output MATCHES "${ERROR}")
+        message(FATAL_ERROR "output of ${SCRIPT} does not match ${ERROR}:\n${output}")
+    endif()
+else()
+    file(READ ${EXPECTED} expected)
+    if(NOT output STREQUAL expected)
+        message(FATAL_ERROR "output of ${SCRIPT} differs from ${EXPECTED}:\n${output}")
+    endif()
+endif()